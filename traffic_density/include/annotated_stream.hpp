@@ -0,0 +1,75 @@
+#ifndef ANNOTATED_STREAM_HPP
+#define ANNOTATED_STREAM_HPP
+
+#include <opencv2/opencv.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "mjpeg_server.hpp"
+#include "traffic_analysis.hpp"
+
+struct StreamConfig {
+    int port = 8081;        // 0 disables the server
+    std::string bindAddress = "0.0.0.0";  // every interface; 127.0.0.1 keeps it local
+    int jpegQuality = 80;
+    bool grid = false;      // overlay drawDebugGrid() on the annotated frames
+    int gridStep = 100;
+
+    // Reads STREAM_* variables, keeping the defaults above for unset keys.
+    static StreamConfig fromEnv();
+};
+
+// Serves every camera's annotated detections as MJPEG over HTTP, replacing the
+// imshow windows on headless machines:
+//
+//   /stream/<camera>          frame with vehicle boxes (+ optional grid)
+//   /stream/<camera>_compare  original | preprocessed side by side
+//
+// <camera> is the slugified camera name. publish*() only hands the frame to
+// the server; drawing and JPEG encoding happen on the connection thread and
+// only while a client is watching.
+class AnnotatedStream {
+public:
+    explicit AnnotatedStream(StreamConfig config);
+    ~AnnotatedStream();
+
+    AnnotatedStream(const AnnotatedStream&) = delete;
+    AnnotatedStream& operator=(const AnnotatedStream&) = delete;
+
+    bool start();
+    void stop();
+    bool enabled() const { return enabled_; }
+
+    // True while a client is connected to the camera's annotated stream.
+    bool watching(const std::string& camera) const;
+
+    // Frames are shared, not copied: do not modify them after publishing.
+    void publish(const std::string& camera, const cv::Mat& frame, const TrafficAnalysis& analysis);
+    void publishComparison(const std::string& camera, const cv::Mat& original, const cv::Mat& processed);
+
+private:
+    struct GridLayer {
+        cv::Mat pixels;
+        cv::Mat mask;
+    };
+
+    std::shared_ptr<const GridLayer> gridLayer(cv::Size size);
+    JpegBuffer encode(const cv::Mat& image) const;
+
+    StreamConfig config_;
+    bool enabled_ = false;
+
+    // The grid never changes for a given frame size, so it is drawn once.
+    std::mutex gridMutex_;
+    std::map<std::pair<int, int>, std::shared_ptr<const GridLayer>> gridCache_;
+
+    // Declared last: connection threads render with the members above, so the
+    // server has to be stopped before they are destroyed.
+    MjpegServer server_;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef CAPTURE_PROCESS_HPP
+#define CAPTURE_PROCESS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "frame_ring.hpp"
+#include "ingest.hpp"
+
+struct CaptureProcessConfig {
+    bool enabled = false;                                   // run capture out of process
+    int ringSlots = 4;
+    size_t slotBytes = 8u << 20;                            // largest frame a slot holds
+    std::chrono::seconds stallTimeout{15};                  // no frame for this long = hung stream
+    std::chrono::milliseconds restartBackoff{2000};
+
+    // Reads CAPTURE_* variables, keeping the defaults above for unset keys.
+    static CaptureProcessConfig fromEnv();
+};
+
+// Body of `main_exec capture <ring> <camera name> <camera url>`: keeps the
+// camera stream open and decodes every frame straight into the shared-memory
+// ring until SIGTERM. Reconnects on its own when the stream drops.
+int runCaptureProcess(const std::string& ringName, const CameraSource& camera);
+
+// Runs one capture process per camera and restarts it when it exits or stops
+// publishing frames, so a hung VideoCapture or a crashing decoder never takes
+// the analyzer (and its loaded model) down with it.
+class CaptureSupervisor {
+public:
+    CaptureSupervisor(CaptureProcessConfig config, std::vector<CameraSource> cameras);
+    ~CaptureSupervisor();
+
+    CaptureSupervisor(const CaptureSupervisor&) = delete;
+    CaptureSupervisor& operator=(const CaptureSupervisor&) = delete;
+
+    bool start();
+    void stop();
+
+    // Leases the newest frame of camera `index` (order of the cameras passed
+    // in) if it is newer than frame number `afterFrame`. Fails when there is
+    // no such frame; stalled() tells a hung camera from one that simply has
+    // not produced the next frame yet.
+    bool latestFrame(size_t index, FrameLease& lease, uint64_t afterFrame = 0);
+
+    // True when camera `index` has not published a frame within the stall
+    // timeout.
+    bool stalled(size_t index) const;
+
+    std::string summary() const;
+
+private:
+    struct Child {
+        CameraSource camera;
+        std::unique_ptr<FrameRing> ring;
+        pid_t pid = -1;
+        std::chrono::steady_clock::time_point startedAt;
+        std::chrono::steady_clock::time_point restartAt;
+        int restarts = 0;
+    };
+
+    bool spawn(size_t index);
+    void monitorLoop();
+
+    CaptureProcessConfig config_;
+    std::string executable_;
+    std::vector<Child> children_;
+
+    mutable std::mutex mutex_;
+    std::atomic<bool> running_{false};
+    std::thread monitor_;
+};
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef DEBUG_FRAME_HPP
+#define DEBUG_FRAME_HPP
+
+#include <opencv2/opencv.hpp>
+
+// Draws a labelled pixel grid every `step` pixels (for picking ROIs by eye).
+void drawDebugGrid(cv::Mat& frame, int step = 100);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef ENV_CONFIG_HPP
+#define ENV_CONFIG_HPP
+
+#include <cstdlib>
+#include <string>
+
+// Small helpers to read tuning knobs from the environment (.env is loaded
+// into the environment by main.cpp before any module reads its config).
+// Malformed values fall back to the default.
+
+inline std::string envString(const char* key, const std::string& fallback) {
+    const char* value = std::getenv(key);
+    return (value && *value) ? std::string(value) : fallback;
+}
+
+inline long envInt(const char* key, long fallback) {
+    const char* value = std::getenv(key);
+    if (!value || !*value) return fallback;
+    char* end = nullptr;
+    long parsed = std::strtol(value, &end, 10);
+    return (end && *end == '\0') ? parsed : fallback;
+}
+
+inline double envDouble(const char* key, double fallback) {
+    const char* value = std::getenv(key);
+    if (!value || !*value) return fallback;
+    char* end = nullptr;
+    double parsed = std::strtod(value, &end);
+    return (end && *end == '\0') ? parsed : fallback;
+}
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef FRAME_RING_HPP
+#define FRAME_RING_HPP
+
+#include <opencv2/opencv.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class FrameRing;
+
+// A frame the analyzer reads straight out of shared memory. While the lease
+// is held the capture process never writes into its slot; anything that has
+// to outlive the lease (stream preview, archive queue) must be copied.
+class FrameLease {
+public:
+    FrameLease() = default;
+    ~FrameLease();
+    FrameLease(FrameLease&& other) noexcept;
+    FrameLease& operator=(FrameLease&& other) noexcept;
+    FrameLease(const FrameLease&) = delete;
+    FrameLease& operator=(const FrameLease&) = delete;
+
+    const cv::Mat& frame() const { return frame_; }
+    uint64_t frameNumber() const { return frameNumber_; }
+    std::chrono::steady_clock::duration age() const;
+
+    void release();
+
+private:
+    friend class FrameRing;
+
+    std::atomic<uint32_t>* readers_ = nullptr;
+    cv::Mat frame_;
+    uint64_t frameNumber_ = 0;
+    int64_t capturedNs_ = 0;
+};
+
+// Fixed-size slots in POSIX shared memory (shm_open + mmap) carrying decoded
+// frames from one capture process to the analyzer.
+//
+// There is a single writer per ring. Each slot has a sequence number that is
+// odd while the writer fills it and a reader count set by FrameLease; the
+// writer skips leased slots, so a frame is never modified while the analyzer
+// is looking at it and no copy is needed on the read side. The writer stamps
+// a heartbeat on every published frame so the supervisor can spot a hung
+// stream.
+class FrameRing {
+public:
+    ~FrameRing();
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    // Creates (or replaces) the ring; the owner unlinks it on destruction.
+    static std::unique_ptr<FrameRing> create(const std::string& name, int slots, size_t slotBytes);
+
+    // Maps an existing ring, as the capture process does.
+    static std::unique_ptr<FrameRing> attach(const std::string& name);
+
+    const std::string& name() const { return name_; }
+    size_t slotBytes() const;
+
+    // Writer side. beginWrite() returns a Mat over a free slot for the given
+    // shape (empty when every slot is leased or the frame does not fit), so
+    // the decoder can write into shared memory directly. endWrite() publishes
+    // the frame, copying it in only if it does not already live in the slot.
+    cv::Mat beginWrite(cv::Size size, int type);
+    bool endWrite(const cv::Mat& frame);
+
+    // Reader side: leases the most recently published frame. Returns false
+    // when nothing newer than `afterFrame` is available.
+    bool acquireLatest(FrameLease& lease, uint64_t afterFrame = 0);
+
+    // Time since the writer last published a frame (or since the ring was
+    // created, before the first frame).
+    std::chrono::steady_clock::duration sinceLastFrame() const;
+
+private:
+    struct Header;
+    struct Slot;
+
+    FrameRing(std::string name, void* base, size_t bytes, bool owner);
+
+    Slot* slot(uint32_t index) const;
+    unsigned char* pixels(uint32_t index) const;
+    bool claimSlot(uint32_t index);
+    void abortWrite();
+
+    std::string name_;
+    void* base_ = nullptr;
+    size_t bytes_ = 0;
+    bool owner_ = false;
+
+    // Writer state (capture process only): the claimed slot and the odd
+    // sequence value it was claimed with.
+    int writing_ = -1;
+    uint64_t writingSequence_ = 0;
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef INGEST_HPP
+#define INGEST_HPP
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct CameraSource {
+    std::string name;       // avenue name used in reports
+    std::string url;        // anything cv::VideoCapture can open
+    bool snapshot = false;  // serves one JPEG per request: poll it with SnapshotFetcher
+};
+
+// Cameras from TRAFFIC_CAMERAS ("Name|url;Name|url|snapshot"), or the default
+// Avenida dos Estados camera when the variable is not set. A trailing
+// "|snapshot" marks a camera that answers every GET with a single JPEG.
+std::vector<CameraSource> load_camera_sources();
+
+// Grabs one frame from the camera without touching the disk.
+bool capture_camera_frame(const CameraSource& camera, cv::Mat& frame);
+
+// Interactive capture used by demo mode (SPACE/Q preview on the first call).
+// Returns {avenueName, frame}; the frame is empty when nothing was captured.
+std::pair<std::string, cv::Mat> ingest_camera_frame();
+
+// Same as ingest_camera_frame() but saves the frame and returns
+// {avenueName, imagePath} for the file based pipeline.
+std::pair<std::string, std::string> ingest_camera();
+
+#endif
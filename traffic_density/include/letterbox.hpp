@@ -0,0 +1,26 @@
+#ifndef LETTERBOX_HPP
+#define LETTERBOX_HPP
+
+#include <opencv2/opencv.hpp>
+
+// Geometry of a letterboxed network input: the frame was scaled by `scale`
+// and placed at (padX, padY) inside a size x size square.
+struct Letterbox {
+    float scale = 1.0f;
+    int padX = 0;
+    int padY = 0;
+    int size = 0;
+};
+
+// Fused replacement for blobFromImage(frame, 1/255, Size(size, size), 0, swapRB=true, crop=false):
+// aspect-preserving bilinear resize, gray (0.5) padding, BGR -> RGB, 1/255
+// scaling and HWC -> CHW in a single pass over the output. `blob` is a
+// 1x3xSxS CV_32F tensor that is only reallocated when its shape changes, so
+// callers should keep it around between frames.
+Letterbox letterboxBlob(const cv::Mat& bgr, int size, cv::Mat& blob);
+
+// Maps a YOLO box (center x/y, width, height, normalized to the network input)
+// back to frame pixels, undoing the letterbox and clipping to the frame.
+cv::Rect unletterboxBox(const Letterbox& box, const float* yolo, cv::Size frameSize);
+
+#endif
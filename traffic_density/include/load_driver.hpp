@@ -0,0 +1,21 @@
+#ifndef LOAD_DRIVER_HPP
+#define LOAD_DRIVER_HPP
+
+#include <string>
+
+struct LoadDriverConfig {
+    int cameras = 8;                                   // cam0 .. cam<N-1> on the simulator
+    std::string baseUrl = "http://127.0.0.1:8090";     // camera_sim address
+    int durationSeconds = 60;
+    bool preprocess = true;                            // run CLAHE + bilateral like a report frame
+    bool snapshots = false;                            // poll /snapshot/camN through SnapshotFetcher
+
+    // Reads LOAD_* variables, keeping the defaults above for unset keys.
+    static LoadDriverConfig fromEnv();
+};
+
+// Points the scheduled pipeline at every simulated camera for a fixed time and
+// prints throughput plus capture / analysis latency percentiles.
+int runLoadDriver(const LoadDriverConfig& config);
+
+#endif
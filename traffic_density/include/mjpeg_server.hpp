@@ -0,0 +1,97 @@
+#ifndef MJPEG_SERVER_HPP
+#define MJPEG_SERVER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using JpegBuffer = std::shared_ptr<const std::vector<unsigned char>>;
+using JpegProducer = std::function<JpegBuffer()>;
+
+// Minimal HTTP/1.1 server publishing named JPEG streams on localhost or LAN.
+// There is no authentication: bind to 127.0.0.1 unless the LAN should see it.
+//
+//   GET /                 plain-text list of streams
+//   GET /stream/<name>    multipart/x-mixed-replace MJPEG (one part per frame)
+//   GET /snapshot/<name>  latest frame as image/jpeg (keep-alive supported)
+//
+// Each connection is served by its own thread and only ever sees the most
+// recent frame: slow clients skip frames instead of queueing them.
+class MjpegServer {
+public:
+    // bindAddress is an IPv4 address; "0.0.0.0" listens on every interface.
+    explicit MjpegServer(int port, std::string bindAddress = "0.0.0.0");
+    ~MjpegServer();
+
+    MjpegServer(const MjpegServer&) = delete;
+    MjpegServer& operator=(const MjpegServer&) = delete;
+
+    bool start();
+    void stop();
+    int port() const { return port_; }
+
+    // Replaces the current frame of a stream (creating the stream if needed).
+    void publishJpeg(const std::string& stream, JpegBuffer jpeg);
+
+    // Replaces the current frame with one that is rendered and encoded only
+    // when a client asks for it. The producer runs on a connection thread, at
+    // most once per published frame, so nobody watching means no encoding.
+    void publishLazy(const std::string& stream, JpegProducer producer);
+
+    // Closes every connection of a stream; used to simulate camera dropouts.
+    void disconnectClients(const std::string& stream);
+
+    // Drops the current frame of a stream until the next publish: stream
+    // clients see no new parts and /snapshot answers 503. Used to simulate
+    // camera dropouts.
+    void clearFrame(const std::string& stream);
+
+    int clientCount(const std::string& stream) const;
+
+private:
+    struct Stream {
+        std::mutex mutex;
+        std::condition_variable cv;
+        JpegBuffer jpeg;
+        JpegProducer producer;      // pending lazy frame, cleared once encoded
+        bool encoding = false;
+        uint64_t sequence = 0;
+        uint64_t generation = 0;    // bumped by disconnectClients()
+        std::atomic<int> clients{0};
+    };
+
+    std::shared_ptr<Stream> stream(const std::string& name, bool create);
+    JpegBuffer currentJpeg(Stream& stream, std::unique_lock<std::mutex>& lock);
+    void acceptLoop();
+    void serveClient(int fd);
+    bool serveStream(int fd, const std::shared_ptr<Stream>& stream);
+    bool serveSnapshot(int fd, const std::shared_ptr<Stream>& stream, bool keepAlive);
+    bool sendAll(int fd, const void* data, size_t size);
+    bool sendText(int fd, int status, const std::string& reason, const std::string& body, bool keepAlive);
+
+    int port_;
+    std::string bindAddress_;
+    int listenFd_ = -1;
+    std::atomic<bool> running_{false};
+
+    mutable std::mutex streamsMutex_;
+    std::map<std::string, std::shared_ptr<Stream>> streams_;
+
+    // Connection threads are detached; stop() waits until activeClients_ is 0.
+    std::mutex clientsMutex_;
+    std::condition_variable clientsCv_;
+    std::set<int> clientFds_;
+    int activeClients_ = 0;
+
+    std::thread acceptThread_;
+};
+
+#endif
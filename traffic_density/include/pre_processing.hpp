@@ -0,0 +1,17 @@
+#ifndef PRE_PROCESSING_HPP
+#define PRE_PROCESSING_HPP
+
+#include <opencv2/opencv.hpp>
+#include <string>
+
+// CLAHE (HSV value channel) followed by a bilateral filter, fully in memory.
+cv::Mat preprocess_frame(const cv::Mat& frame);
+
+// Shows the original and filtered frame side by side (main thread only).
+void show_preprocessing(const cv::Mat& original, const cv::Mat& processed);
+
+// File based variants: write the filtered frame and return its path.
+std::string preprocess_static(const cv::Mat& frame, const std::string& avenue_name);
+std::string test_static_image(const std::string& image_path, const std::string& avenue_name);
+
+#endif
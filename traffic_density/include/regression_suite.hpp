@@ -0,0 +1,39 @@
+#ifndef REGRESSION_SUITE_HPP
+#define REGRESSION_SUITE_HPP
+
+#include <string>
+#include <vector>
+
+struct RegressionConfig {
+    std::string imagesRoot = "../resources/images";
+    std::vector<std::string> imageDirs = {"avenida_dos_estados", "demo"};  // relative to imagesRoot
+    std::string goldenPath = "../resources/golden/detections.json";
+    std::string baselinePath = "../resources/golden/latency_baseline.json";
+
+    int countTolerance = 1;             // allowed vehicle count difference per image
+    int boxTolerance = 1;               // allowed missing and, separately, extra boxes per image
+    double densityTolerance = 0.005;    // allowed absolute density difference per image
+    double iouThreshold = 0.5;          // two boxes match when they overlap at least this much
+    double latencyMargin = 0.25;        // allowed slowdown per stage (0.25 = 25%); < 0 skips the check
+    bool update = false;                // rewrite golden + baseline instead of comparing
+
+    // Reads REGRESS_* variables, keeping the defaults above for unset keys.
+    static RegressionConfig fromEnv();
+};
+
+// Exit code of runRegressionSuite() when the golden file does not exist yet;
+// CTest reports it as a skip (SKIP_RETURN_CODE) instead of a failure.
+constexpr int kRegressionSkipped = 77;
+
+// Runs preprocessing + detection over the bundled screenshots and compares
+// counts, boxes (IoU) and density against the golden JSON and the median
+// per-stage latency against the stored baseline. Returns a process exit
+// code: 0 when everything is within tolerance, kRegressionSkipped when there
+// is no golden file to compare against, 1 otherwise.
+int runRegressionSuite(const RegressionConfig& config);
+
+// Times blobFromImage against the fused letterboxBlob kernel on the same
+// bundled images and prints the median per-frame cost of each.
+int runBlobBenchmark(const RegressionConfig& config, int iterations);
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef SAMPLING_SCHEDULER_HPP
+#define SAMPLING_SCHEDULER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Tuning knobs for SamplingScheduler. Defaults match the old live loop
+// (30 s reports) while letting busy cameras be sampled much more often.
+struct SchedulerConfig {
+    std::chrono::milliseconds minInterval{1000};    // busiest camera
+    std::chrono::milliseconds maxInterval{30000};   // quiet camera
+    double volatilityReference = 0.01;  // density change per sample treated as "fully active"
+    double volatilitySmoothing = 0.3;   // EWMA weight of the newest sample
+    int nightStartHour = 0;             // [start, end) local hours with little traffic
+    int nightEndHour = 5;
+    double nightIntervalFactor = 3.0;   // interval multiplier during the night window
+    int workers = 2;                    // detection jobs running concurrently
+    double cpuBudget = 0.75;            // fraction of all cores the process may consume
+
+    // Reads SCHEDULER_* variables, keeping the defaults above for unset keys.
+    static SchedulerConfig fromEnv();
+};
+
+// A sampling job captures and analyzes one frame of a camera and returns the
+// measured density, or a negative value if the camera could not be sampled.
+using SampleJob = std::function<double()>;
+
+// Returned by a job whose camera has no frame newer than the one it analyzed
+// last. Nothing was measured: the camera keeps its interval and volatility,
+// and the sample is counted as skipped rather than failed.
+constexpr double kSampleSkipped = -2.0;
+
+// Told a camera's sampling interval whenever it changes (and once at start),
+// so frame sources can poll the camera at a matching cadence.
+using IntervalListener = std::function<void(std::chrono::milliseconds)>;
+
+struct CameraStats {
+    std::string name;
+    std::chrono::milliseconds interval{0};
+    double lastDensity = 0.0;
+    double volatility = 0.0;
+    uint64_t samples = 0;
+    uint64_t failures = 0;
+    uint64_t skipped = 0;                // no new frame since the previous sample
+    uint64_t missedDeadlines = 0;
+    double meanLatencyMs = 0.0;
+};
+
+// Earliest-deadline-first scheduler for per-camera detection jobs.
+//
+// Every camera is released again one interval after its previous sample
+// started; the interval shrinks when the camera's density is volatile and
+// grows at night. A released job must finish before its next release, which
+// is its deadline, and released jobs are handed to the worker pool in
+// deadline order. Dispatching pauses while the process has used up its CPU
+// budget (token bucket refilled at cpuBudget * cores CPU-seconds per second).
+class SamplingScheduler {
+public:
+    explicit SamplingScheduler(SchedulerConfig config);
+    ~SamplingScheduler();
+
+    SamplingScheduler(const SamplingScheduler&) = delete;
+    SamplingScheduler& operator=(const SamplingScheduler&) = delete;
+
+    // Cameras must be registered before start().
+    void addCamera(const std::string& name, SampleJob job, IntervalListener onInterval = nullptr);
+
+    void start();
+    void stop();
+
+    std::vector<CameraStats> stats() const;
+    std::string summary() const;
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct Camera {
+        std::string name;
+        SampleJob job;
+        IntervalListener onInterval;
+        CameraStats stats;
+        bool hasDensity = false;
+        double totalLatencyMs = 0.0;
+    };
+
+    struct Release {
+        clock::time_point release;
+        clock::time_point deadline;
+        size_t camera;
+    };
+    struct LaterRelease {
+        bool operator()(const Release& a, const Release& b) const { return a.release > b.release; }
+    };
+    struct LaterDeadline {
+        bool operator()(const Release& a, const Release& b) const { return a.deadline > b.deadline; }
+    };
+
+    void dispatchLoop();
+    void workerLoop();
+    void complete(const Release& task, clock::time_point started, double density);
+    std::chrono::milliseconds computeInterval(const Camera& camera) const;
+    bool isNight() const;
+    void refillBudget(clock::time_point now);
+
+    SchedulerConfig config_;
+    std::vector<Camera> cameras_;
+
+    std::priority_queue<Release, std::vector<Release>, LaterRelease> pending_;
+    std::priority_queue<Release, std::vector<Release>, LaterDeadline> released_;
+    std::deque<Release> ready_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable dispatchCv_;
+    std::condition_variable workCv_;
+    bool running_ = false;
+    int idleWorkers_ = 0;
+
+    double cpuRate_ = 1.0;          // CPU-seconds granted per wall second
+    double cpuTokens_ = 0.0;
+    double lastCpuSeconds_ = 0.0;
+    clock::time_point lastRefill_;
+
+    std::thread dispatcher_;
+    std::vector<std::thread> workers_;
+};
+
+#endif
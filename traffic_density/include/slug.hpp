@@ -0,0 +1,18 @@
+#ifndef SLUG_HPP
+#define SLUG_HPP
+
+#include <cctype>
+#include <string>
+
+// "Avenida dos Estados" -> "avenida_dos_estados"; safe for paths and URLs.
+inline std::string slugify(const std::string& text) {
+    std::string slug;
+    for (unsigned char c : text) {
+        if (std::isalnum(c)) slug += static_cast<char>(std::tolower(c));
+        else if (!slug.empty() && slug.back() != '_') slug += '_';
+    }
+    while (!slug.empty() && slug.back() == '_') slug.pop_back();
+    return slug.empty() ? "camera" : slug;
+}
+
+#endif
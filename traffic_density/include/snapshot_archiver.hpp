@@ -0,0 +1,94 @@
+#ifndef SNAPSHOT_ARCHIVER_HPP
+#define SNAPSHOT_ARCHIVER_HPP
+
+#include <opencv2/opencv.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+struct ArchiverConfig {
+    std::string rootDir = "../resources/images/archive";  // one sub-directory per camera
+    size_t queueCapacity = 16;          // snapshots waiting for the writer; extra ones are dropped
+    int jpegQuality = 85;
+    uint64_t quotaBytesPerCamera = 200ull * 1024 * 1024;   // 0 disables archiving
+    std::chrono::seconds heartbeat{0};  // also keep one frame per interval without transitions (0 = off)
+
+    // Reads ARCHIVE_* variables, keeping the defaults above for unset keys.
+    static ArchiverConfig fromEnv();
+};
+
+// Persists selected camera frames as JPEG on a background thread.
+//
+// Only frames that matter are kept: the first one of a camera, every change of
+// traffic condition (e.g. light -> heavy) and optionally a heartbeat frame.
+// offer() never blocks on disk: when the queue is full the snapshot is dropped
+// and the transition is retried with the next frame of that camera.
+// Each camera directory is capped at quotaBytesPerCamera by deleting its
+// oldest snapshots first.
+class SnapshotArchiver {
+public:
+    explicit SnapshotArchiver(ArchiverConfig config);
+    ~SnapshotArchiver();
+
+    SnapshotArchiver(const SnapshotArchiver&) = delete;
+    SnapshotArchiver& operator=(const SnapshotArchiver&) = delete;
+
+    void start();
+    void stop();   // flushes the queue before returning
+
+    // Applies the sampling policy and queues the frame if it should be kept.
+    // Only queued frames are copied, so `frame` may be a view over a buffer the
+    // caller reuses (such as a shared-memory ring slot).
+    bool offer(const std::string& camera, const std::string& condition, const cv::Mat& frame);
+
+    uint64_t written() const;
+    uint64_t dropped() const;
+
+private:
+    struct Snapshot {
+        std::string camera;
+        std::string tag;
+        cv::Mat frame;
+        std::chrono::system_clock::time_point capturedAt;
+    };
+
+    struct PolicyState {
+        std::string lastCondition;
+        std::chrono::steady_clock::time_point lastArchived;
+        bool seen = false;
+    };
+
+    struct CameraDir {
+        std::filesystem::path dir;
+        std::deque<std::pair<std::filesystem::path, uint64_t>> files;  // oldest first
+        uint64_t bytes = 0;
+    };
+
+    void writerLoop();
+    void write(const Snapshot& snapshot);
+    CameraDir& cameraDir(const std::string& camera);
+    void enforceQuota(CameraDir& dir);
+
+    ArchiverConfig config_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Snapshot> queue_;
+    std::unordered_map<std::string, PolicyState> policy_;
+    bool running_ = false;
+    uint64_t written_ = 0;
+    uint64_t dropped_ = 0;
+
+    std::unordered_map<std::string, CameraDir> dirs_;  // writer thread only
+    std::thread writer_;
+};
+
+#endif
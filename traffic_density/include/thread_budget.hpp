@@ -0,0 +1,76 @@
+#ifndef THREAD_BUDGET_HPP
+#define THREAD_BUDGET_HPP
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class WorkerRole { Capture = 0, Preprocess = 1, Inference = 2 };
+
+struct ThreadBudgetConfig {
+    bool enabled = true;
+    int captureCores = 0;       // 0 = automatic split
+    int preprocessCores = 0;
+    int inferenceCores = 0;
+    bool pin = true;            // restrict each stage to its cores
+
+    // Reads THREAD_BUDGET_* variables, keeping the defaults above for unset keys.
+    static ThreadBudgetConfig fromEnv();
+};
+
+// Splits the cores this process may run on between the capture, preprocessing
+// and inference stage threads, so several cameras don't oversubscribe the
+// machine.
+//
+// Cores are taken NUMA node by node, so a role stays on one node whenever it
+// fits. Pipeline stages wrap their work in a ThreadBudget::Scope, which pins
+// the calling thread (only that thread) to the role's cores and charges its
+// CPU time to the role. OpenCV's pool is process wide and shared by all
+// stages, so it is not part of the split: it is sized to the inference cores
+// and started unpinned, spanning every allowed core.
+class ThreadBudget {
+public:
+    static ThreadBudget& instance();
+
+    // Computes the split and starts OpenCV's pool; call from the (unpinned)
+    // main thread before starting any worker threads.
+    void configure(const ThreadBudgetConfig& config);
+
+    // CPU utilization since the previous report: per role for the pinned
+    // stage threads inside a Scope, then everything else (OpenCV's pool and
+    // helper threads) and the whole process.
+    std::string report();
+
+    class Scope {
+    public:
+        explicit Scope(WorkerRole role);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        WorkerRole role_;
+        double cpuStart_;
+        bool pinned_ = false;
+    };
+
+private:
+    ThreadBudget() = default;
+
+    bool pin(WorkerRole role);
+    void unpin();
+    void charge(WorkerRole role, double cpuSeconds);
+
+    std::mutex mutex_;
+    bool configured_ = false;
+    bool pinning_ = false;
+    int poolThreads_ = 0;
+    std::vector<int> allowedCores_;             // process affinity at configure()
+    std::vector<int> roleCores_[3];
+    double roleCpuSeconds_[3] = {0.0, 0.0, 0.0};
+    double lastProcessCpu_ = 0.0;
+    std::chrono::steady_clock::time_point lastReport_;
+};
+
+#endif
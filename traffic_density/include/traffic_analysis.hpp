@@ -0,0 +1,43 @@
+#ifndef TRAFFIC_ANALYSIS_HPP
+#define TRAFFIC_ANALYSIS_HPP
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+// Wall-clock time spent in each detection stage of analyzeTrafficFrame().
+struct StageTimings {
+    double blobMs = 0.0;        // resize + normalization into the input blob
+    double inferenceMs = 0.0;   // YOLO forward pass
+    double decodeMs = 0.0;      // box decoding, NMS and density
+};
+
+// Result of running vehicle detection on one in-memory frame.
+struct TrafficAnalysis {
+    bool ok = false;
+    int vehicleCount = 0;
+    double density = 0.0;
+    std::string condition;
+    std::vector<cv::Rect> boxes;    // vehicle boxes kept after NMS, in frame pixels
+    std::string report;             // "N vehicles detected with density D. Condition: C" or "Error: ..."
+    StageTimings timings;
+};
+
+// Detects vehicles on an already decoded BGR frame. The YOLO network is loaded
+// once per calling thread, so scheduler workers can call this concurrently.
+TrafficAnalysis analyzeTrafficFrame(const cv::Mat& image);
+
+// Rounded vehicle box used by every annotated output.
+void drawRoundedRectangle(cv::Mat& img, cv::Rect box, cv::Scalar color, int thickness = 2);
+
+// Draws the detected boxes and labels onto the frame in place.
+void drawTrafficAnalysis(cv::Mat& image, const TrafficAnalysis& analysis);
+
+// Draws the detected boxes on a copy of the frame and shows it in a window.
+// Must be called from the main thread.
+void showTrafficAnalysis(const cv::Mat& frame, const TrafficAnalysis& analysis);
+
+// File based entry point: loads the image, analyzes it and shows the result.
+std::string analyzeTrafficDensity(const std::string& imagePath, const std::string& avenueName);
+
+#endif
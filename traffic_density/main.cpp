@@ -10,8 +10,23 @@
 #include <cstdlib>
 #include <fstream>
 #include <sstream>
+#include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
 
+#include "annotated_stream.hpp"
+#include "capture_process.hpp"
+#include "env_config.hpp"
+#include "ingest.hpp"
+#include "load_driver.hpp"
+#include "pre_processing.hpp"
+#include "regression_suite.hpp"
+#include "sampling_scheduler.hpp"
+#include "snapshot_archiver.hpp"
+#include "snapshot_fetcher.hpp"
+#include "thread_budget.hpp"
+#include "traffic_analysis.hpp"
+
 // AWS SDK includes
 #ifdef USE_AWS_SNS
 #include <aws/core/Aws.h>
@@ -288,7 +303,7 @@ int main(int argc, char* argv[]) {
     std::string mode;
     if (argc > 1) mode = argv[1];
     else {
-        std::cout << "Select mode (demo/live): ";
+        std::cout << "Select mode (demo/live/regress/load/bench): ";
         std::cin >> mode;
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     }
@@ -298,20 +313,37 @@ int main(int argc, char* argv[]) {
 
     if (mode == "demo") {
         std::cout << "Entering demo mode. Press ENTER at any time to stop.\n";
+        // Snapshots are written by a background thread with a per-camera disk quota
+        SnapshotArchiver archiver(ArchiverConfig::fromEnv());
+        archiver.start();
+
+        // Annotated frames are served over HTTP; the OpenCV windows are opt-in
+        AnnotatedStream stream(StreamConfig::fromEnv());
+        stream.start();
+        const bool showWindows = envInt("SHOW_WINDOWS", 0) != 0;
+
         while (true) {
-            auto [avenueName, imagePath] = image_capture_live();
+            auto [avenueName, frame] = ingest_camera_frame();
 
-            if (imagePath.empty()) {
+            if (frame.empty()) {
                 std::cout << "No demo images. Exiting demo mode.\n";
                 break;
             }
 
-            std::string processedImagePath = test_static_image(imagePath, avenueName);
-            std::string report = analyzeTrafficDensity(processedImagePath, avenueName);
+            cv::Mat processed = preprocess_frame(frame);
+            if (showWindows) show_preprocessing(frame, processed);
+            stream.publishComparison(avenueName, frame, processed);
+
+            TrafficAnalysis analysis = analyzeTrafficFrame(processed);
+            if (analysis.ok) {
+                if (showWindows) showTrafficAnalysis(processed, analysis);
+                stream.publish(avenueName, processed, analysis);
+                archiver.offer(avenueName, analysis.condition, frame);
+            }
 
             sendTrafficNotification(
                 avenueName,
-                report
+                analysis.report
             );
 
             // Wait 5 seconds, exit early if user presses ENTER
@@ -330,50 +362,177 @@ int main(int argc, char* argv[]) {
     else if (mode == "live") {
         std::cout << "Entering live mode. Press ENTER at any time to stop.\n";
         using clock = std::chrono::steady_clock;
-        auto lastReport = clock::now() - std::chrono::seconds(30);
-
-        while (true) {
-            if (userRequestedExit()) {
-                std::string line;
-                std::getline(std::cin, line); // consume input
-                std::cout << "Exit requested. Leaving live mode...\n";
-                return 0;
+        const auto reportInterval = std::chrono::seconds(envInt("REPORT_INTERVAL_SECONDS", 30));
+
+        SnapshotArchiver archiver(ArchiverConfig::fromEnv());
+        archiver.start();
+
+        AnnotatedStream stream(StreamConfig::fromEnv());
+        stream.start();
+
+        // Each camera is sampled at its own adaptive cadence; see SamplingScheduler.
+        SchedulerConfig schedulerConfig = SchedulerConfig::fromEnv();
+        ThreadBudget::instance().configure(ThreadBudgetConfig::fromEnv());
+        SamplingScheduler scheduler(schedulerConfig);
+        std::mutex notificationMutex;
+
+        // Cameras marked "|snapshot" in TRAFFIC_CAMERAS are polled by one
+        // event-loop thread. With CAPTURE_PROCESSES=1 the remaining cameras are
+        // read by child processes into shared-memory rings.
+        std::vector<CameraSource> cameras = load_camera_sources();
+        FetcherConfig fetchConfig = FetcherConfig::fromEnv();
+        std::vector<CameraSource> polledCameras, streamedCameras;
+        std::vector<size_t> sourceIndex;    // position of each camera within its group
+        std::vector<bool> polledCamera;
+        for (const CameraSource& camera : cameras) {
+            bool polled = fetchConfig.enabled && camera.snapshot && SnapshotFetcher::supports(camera.url);
+            if (camera.snapshot && !polled) {
+                std::cerr << "[LIVE] " << camera.name << ": "
+                          << (fetchConfig.enabled ? "only plain http:// snapshots can be polled" : "FETCH_SNAPSHOTS=0")
+                          << ", using VideoCapture\n";
             }
+            polledCamera.push_back(polled);
+            std::vector<CameraSource>& group = polled ? polledCameras : streamedCameras;
+            sourceIndex.push_back(group.size());
+            group.push_back(camera);
+        }
 
-            auto [avenueName, imagePath] = image_capture_live();
-            if (imagePath.empty()) {
-                std::this_thread::sleep_for(std::chrono::seconds(1));
-                continue;
+        std::unique_ptr<SnapshotFetcher> fetcher;
+        if (!polledCameras.empty()) {
+            fetcher = std::make_unique<SnapshotFetcher>(fetchConfig, polledCameras);
+            if (!fetcher->start()) fetcher.reset();
+        }
+        std::unique_ptr<CaptureSupervisor> captures;
+        CaptureProcessConfig captureConfig = CaptureProcessConfig::fromEnv();
+        if (captureConfig.enabled && !streamedCameras.empty()) {
+            captures = std::make_unique<CaptureSupervisor>(captureConfig, streamedCameras);
+            if (!captures->start()) {
+                std::cerr << "[LIVE] Capture processes unavailable, capturing in-process\n";
+                captures.reset();
             }
+        }
 
-            auto now = clock::now();
-            bool shouldReport = (now - lastReport) >= std::chrono::seconds(30);
+        for (size_t i = 0; i < cameras.size(); ++i) {
+            const CameraSource& camera = cameras[i];
+            size_t index = sourceIndex[i];
+            bool polled = polledCamera[i];
+            SnapshotFetcher* snapshots = polled ? fetcher.get() : nullptr;
+            CaptureSupervisor* supervisor = polled ? nullptr : captures.get();
+            // Only one job per camera is in flight at a time, so this needs no lock.
+            auto lastReport = std::make_shared<clock::time_point>(clock::now() - reportInterval);
+            auto lastFrame = std::make_shared<uint64_t>(0);    // sequence / ring frame number last analyzed
+
+            scheduler.addCamera(camera.name, [camera, index, snapshots, supervisor, lastReport, lastFrame, reportInterval, &notificationMutex, &archiver, &stream]() -> double {
+                cv::Mat frame;
+                FrameLease lease;   // keeps a ring frame from being overwritten until the job returns
+                {
+                    ThreadBudget::Scope scope(WorkerRole::Capture);
+                    if (snapshots) {
+                        uint64_t sequence = 0;
+                        if (!snapshots->latestFrame(index, frame, sequence)) {
+                            return -1.0;
+                        }
+                        if (sequence == *lastFrame) {
+                            return kSampleSkipped;
+                        }
+                        *lastFrame = sequence;
+                    } else if (supervisor) {
+                        // Only frames the child published since the last sample.
+                        if (!supervisor->latestFrame(index, lease, *lastFrame)) {
+                            return supervisor->stalled(index) ? -1.0 : kSampleSkipped;
+                        }
+                        *lastFrame = lease.frameNumber();
+                        frame = lease.frame();
+                    } else if (!capture_camera_frame(camera, frame)) {
+                        return -1.0;
+                    }
+                }
 
-            std::string analysisPath = imagePath;
-            if (shouldReport) {
-                std::string processedImagePath = test_static_image(imagePath, avenueName);
-                if (!processedImagePath.empty()) {
-                    analysisPath = processedImagePath;
+                auto now = clock::now();
+                bool shouldReport = (now - *lastReport) >= reportInterval;
+
+                // The expensive filters only run for frames that end up in a report.
+                cv::Mat input = frame;
+                if (shouldReport) {
+                    ThreadBudget::Scope scope(WorkerRole::Preprocess);
+                    input = preprocess_frame(frame);
+                }
+
+                TrafficAnalysis analysis;
+                {
+                    ThreadBudget::Scope scope(WorkerRole::Inference);
+                    analysis = analyzeTrafficFrame(input);
+                }
+                if (!analysis.ok) {
+                    std::cerr << "[LIVE] " << camera.name << ": " << analysis.report << "\n";
+                    return -1.0;
                 }
-            }
 
-            std::string report = analyzeTrafficDensity(analysisPath, avenueName);
+                // The stream keeps its frame after the lease is gone, so ring
+                // frames are copied, and only when somebody can see them.
+                if (!supervisor || shouldReport || stream.watching(camera.name)) {
+                    cv::Mat shown = supervisor ? frame.clone() : frame;
+                    stream.publish(camera.name, shown, analysis);
+                    if (shouldReport) stream.publishComparison(camera.name, shown, input);
+                }
+                archiver.offer(camera.name, analysis.condition, frame);
 
-            if (shouldReport && !report.empty()) {
-                sendTrafficNotification(
-                    avenueName,
-                    report
-                );
-                lastReport = now;
-            }
+                if (shouldReport) {
+                    std::lock_guard<std::mutex> lock(notificationMutex);
+                    sendTrafficNotification(camera.name, analysis.report);
+                    *lastReport = now;
+                }
+                return analysis.density;
+            }, [snapshots, index](std::chrono::milliseconds interval) {
+                // Polled cameras are fetched at the cadence they are sampled at.
+                if (snapshots) snapshots->setInterval(index, interval);
+            });
+        }
 
-            if (!imagePath.empty()) {
-                std::error_code ec;
-                std::filesystem::remove(imagePath, ec);
-            }
+        scheduler.start();
+        auto lastSummary = clock::now();
 
+        while (!userRequestedExit()) {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            if (clock::now() - lastSummary >= reportInterval) {
+                std::cout << scheduler.summary() << ThreadBudget::instance().report();
+                if (captures) std::cout << captures->summary();
+                if (fetcher) std::cout << fetcher->summary();
+                lastSummary = clock::now();
+            }
+        }
+
+        std::string line;
+        std::getline(std::cin, line); // consume input
+        std::cout << "Exit requested. Leaving live mode...\n";
+        scheduler.stop();
+        if (captures) captures->stop();
+        if (fetcher) fetcher->stop();
+        std::cout << scheduler.summary();
+        return 0;
+    }
+    else if (mode == "capture") {
+        // Child process started by CaptureSupervisor: main_exec capture <ring> <camera name> <camera url>
+        if (argc < 5) {
+            std::cerr << "Usage: main_exec capture <ring> <camera name> <camera url>\n";
+            return 1;
         }
+        return runCaptureProcess(argv[2], CameraSource{argv[3], argv[4]});
+    }
+    else if (mode == "regress") {
+        // Golden-output accuracy + latency check; './main_exec regress --update' rewrites the references
+        RegressionConfig config = RegressionConfig::fromEnv();
+        config.update = (argc > 2 && std::string(argv[2]) == "--update");
+        return runRegressionSuite(config);
+    }
+    else if (mode == "load") {
+        // Offline load test against tools/camera_simulator (camera_sim)
+        return runLoadDriver(LoadDriverConfig::fromEnv());
+    }
+    else if (mode == "bench") {
+        // Input-tensor micro-benchmark: blobFromImage vs the fused letterbox kernel
+        int iterations = argc > 2 ? std::atoi(argv[2]) : 50;
+        return runBlobBenchmark(RegressionConfig::fromEnv(), iterations);
     }
     else {
         std::cout << "Invalid mode.\n";
@@ -0,0 +1,236 @@
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "capture_process.hpp"
+#include "env_config.hpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static volatile sig_atomic_t g_captureRunning = 1;
+
+CaptureProcessConfig CaptureProcessConfig::fromEnv() {
+    CaptureProcessConfig config;
+    config.enabled = envInt("CAPTURE_PROCESSES", config.enabled ? 1 : 0) != 0;
+    config.ringSlots = max(2, static_cast<int>(envInt("CAPTURE_RING_SLOTS", config.ringSlots)));
+    config.slotBytes = static_cast<size_t>(max(1L, envInt("CAPTURE_SLOT_MB", static_cast<long>(config.slotBytes >> 20)))) << 20;
+    config.stallTimeout = chrono::seconds(max(1L, envInt("CAPTURE_STALL_SECONDS", config.stallTimeout.count())));
+    config.restartBackoff = chrono::milliseconds(max(0L, envInt("CAPTURE_RESTART_BACKOFF_MS", config.restartBackoff.count())));
+    return config;
+}
+
+// Sleeps in small steps so SIGTERM is honoured promptly.
+static void captureSleep(chrono::milliseconds duration) {
+    auto until = chrono::steady_clock::now() + duration;
+    while (g_captureRunning && chrono::steady_clock::now() < until) {
+        this_thread::sleep_for(chrono::milliseconds(50));
+    }
+}
+
+int runCaptureProcess(const string& ringName, const CameraSource& camera) {
+    signal(SIGTERM, [](int) { g_captureRunning = 0; });
+    signal(SIGINT, SIG_IGN);  // ENTER/Ctrl-C belong to the analyzer
+
+    unique_ptr<FrameRing> ring = FrameRing::attach(ringName);
+    if (!ring) return 1;
+    // Flushed right away: a hung capture process is killed with SIGKILL.
+    cout << "[CAPTURE] " << camera.name << " -> " << ringName << " (pid " << getpid() << ")" << endl;
+
+    cv::VideoCapture cap;
+    cv::Size lastSize;
+    int lastType = CV_8UC3;
+    bool warnedTooLarge = false;
+
+    while (g_captureRunning) {
+        if (!cap.isOpened() && !cap.open(camera.url)) {
+            cerr << "[CAPTURE] Unable to open stream for " << camera.name << "\n";
+            captureSleep(chrono::milliseconds(1000));
+            continue;
+        }
+
+        // Decode directly into a ring slot when the frame shape is known.
+        cv::Mat frame = ring->beginWrite(lastSize, lastType);
+        if (!cap.read(frame) || frame.empty()) {
+            ring->endWrite(cv::Mat());
+            cerr << "[CAPTURE] Stream ended for " << camera.name << ", reconnecting\n";
+            cap.release();
+            captureSleep(chrono::milliseconds(1000));
+            continue;
+        }
+        lastSize = frame.size();
+        lastType = frame.type();
+
+        if (!ring->endWrite(frame) && frame.total() * frame.elemSize() > ring->slotBytes() && !warnedTooLarge) {
+            cerr << "[CAPTURE] " << camera.name << ": " << frame.cols << "x" << frame.rows
+                 << " frames exceed the ring slot size (raise CAPTURE_SLOT_MB)\n";
+            warnedTooLarge = true;
+        }
+    }
+
+    cout << "[CAPTURE] " << camera.name << " stopped\n";
+    return 0;
+}
+
+CaptureSupervisor::CaptureSupervisor(CaptureProcessConfig config, vector<CameraSource> cameras)
+    : config_(move(config)) {
+    for (CameraSource& camera : cameras) {
+        Child child;
+        child.camera = move(camera);
+        children_.push_back(move(child));
+    }
+
+    error_code ec;
+    fs::path self = fs::read_symlink("/proc/self/exe", ec);
+    executable_ = ec ? "./main_exec" : self.string();
+}
+
+CaptureSupervisor::~CaptureSupervisor() {
+    stop();
+}
+
+bool CaptureSupervisor::start() {
+    if (running_) return true;
+
+    for (size_t i = 0; i < children_.size(); ++i) {
+        string name = "/traffic_density_" + to_string(getpid()) + "_" + to_string(i);
+        children_[i].ring = FrameRing::create(name, config_.ringSlots, config_.slotBytes);
+        if (!children_[i].ring) {
+            for (Child& child : children_) child.ring.reset();
+            return false;
+        }
+    }
+
+    running_ = true;
+    for (size_t i = 0; i < children_.size(); ++i) spawn(i);
+    monitor_ = thread(&CaptureSupervisor::monitorLoop, this);
+    cout << "[CAPTURE] " << children_.size() << " capture process(es) started\n";
+    return true;
+}
+
+void CaptureSupervisor::stop() {
+    if (!running_.exchange(false)) return;
+    if (monitor_.joinable()) monitor_.join();
+
+    for (Child& child : children_) {
+        if (child.pid > 0) kill(child.pid, SIGTERM);
+    }
+    // A process stuck inside VideoCapture may never see SIGTERM.
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(2);
+    for (Child& child : children_) {
+        while (child.pid > 0) {
+            if (waitpid(child.pid, nullptr, WNOHANG) != 0) {
+                child.pid = -1;
+            } else if (chrono::steady_clock::now() >= deadline) {
+                kill(child.pid, SIGKILL);
+                waitpid(child.pid, nullptr, 0);
+                child.pid = -1;
+            } else {
+                this_thread::sleep_for(chrono::milliseconds(20));
+            }
+        }
+        child.ring.reset();
+    }
+}
+
+bool CaptureSupervisor::spawn(size_t index) {
+    Child& child = children_[index];
+
+    // Everything the child needs is prepared before fork(): only
+    // async-signal-safe calls are allowed in a forked multithreaded process.
+    // The camera itself goes on the command line: the supervisor may own only a
+    // subset of TRAFFIC_CAMERAS, so an index would not mean the same to the child.
+    string ringName = child.ring->name();
+    const char* argv[] = {executable_.c_str(), "capture", ringName.c_str(),
+                          child.camera.name.c_str(), child.camera.url.c_str(), nullptr};
+    pid_t parent = getpid();
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        cerr << "[CAPTURE] fork failed for " << child.camera.name << ": " << strerror(errno) << "\n";
+        child.restartAt = chrono::steady_clock::now() + config_.restartBackoff;
+        return false;
+    }
+    if (pid == 0) {
+        // Die with the analyzer instead of writing into an orphaned ring.
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        if (getppid() != parent) _exit(1);
+        execv(argv[0], const_cast<char* const*>(argv));
+        _exit(127);
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    child.pid = pid;
+    child.startedAt = chrono::steady_clock::now();
+    return true;
+}
+
+void CaptureSupervisor::monitorLoop() {
+    while (running_) {
+        auto now = chrono::steady_clock::now();
+        for (size_t i = 0; i < children_.size() && running_; ++i) {
+            Child& child = children_[i];
+
+            if (child.pid > 0) {
+                int status = 0;
+                if (waitpid(child.pid, &status, WNOHANG) == child.pid) {
+                    cerr << "[CAPTURE] " << child.camera.name << " capture process "
+                         << (WIFSIGNALED(status) ? "killed by signal " + to_string(WTERMSIG(status))
+                                                 : "exited with status " + to_string(WEXITSTATUS(status)))
+                         << ", restarting\n";
+                    lock_guard<mutex> lock(mutex_);
+                    child.pid = -1;
+                    child.restarts++;
+                    child.restartAt = now + config_.restartBackoff;
+                } else if (now - child.startedAt > config_.stallTimeout &&
+                           child.ring->sinceLastFrame() > config_.stallTimeout) {
+                    cerr << "[CAPTURE] " << child.camera.name << " produced no frame for "
+                         << config_.stallTimeout.count() << "s, killing pid " << child.pid << "\n";
+                    kill(child.pid, SIGKILL);  // reaped and restarted on the next pass
+                    child.startedAt = now;
+                }
+            }
+
+            if (child.pid < 0 && now >= child.restartAt) spawn(i);
+        }
+        this_thread::sleep_for(chrono::milliseconds(200));
+    }
+}
+
+bool CaptureSupervisor::latestFrame(size_t index, FrameLease& lease, uint64_t afterFrame) {
+    if (index >= children_.size() || !children_[index].ring) return false;
+    if (!children_[index].ring->acquireLatest(lease, afterFrame)) return false;
+    if (lease.age() > config_.stallTimeout) {
+        lease.release();
+        return false;
+    }
+    return true;
+}
+
+bool CaptureSupervisor::stalled(size_t index) const {
+    if (index >= children_.size() || !children_[index].ring) return true;
+    return children_[index].ring->sinceLastFrame() > config_.stallTimeout;
+}
+
+string CaptureSupervisor::summary() const {
+    lock_guard<mutex> lock(mutex_);
+    ostringstream out;
+    out << "[CAPTURE]";
+    for (const Child& child : children_) {
+        double idle = child.ring ? chrono::duration<double>(child.ring->sinceLastFrame()).count() : 0.0;
+        out << " " << child.camera.name << ": pid=" << child.pid << " restarts=" << child.restarts
+            << " last_frame=" << static_cast<int>(idle) << "s ago;";
+    }
+    out << "\n";
+    return out.str();
+}
@@ -0,0 +1,292 @@
+#include "frame_ring.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static_assert(atomic<uint64_t>::is_always_lock_free && atomic<uint32_t>::is_always_lock_free,
+              "the frame ring needs lock-free atomics to be shared between processes");
+
+static const uint32_t kRingMagic = 0x54524652;  // "TRFR"
+static const uint32_t kRingVersion = 1;
+static const size_t kAlignment = 64;
+
+static size_t alignUp(size_t value) {
+    return (value + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+// steady_clock is CLOCK_MONOTONIC on Linux, so both processes agree on it.
+static int64_t nowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct FrameRing::Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t reserved;
+    uint64_t slotBytes;             // pixel capacity of one slot
+    uint64_t slotStride;            // slot header + pixels, cache-line aligned
+    atomic<uint64_t> published;     // frame number of the newest frame (0 = none yet)
+    atomic<uint32_t> latestSlot;    // slot holding that frame
+    atomic<int64_t> lastFrameNs;    // writer heartbeat
+};
+
+struct FrameRing::Slot {
+    atomic<uint64_t> sequence;      // odd while the writer owns the slot
+    atomic<uint32_t> readers;       // outstanding FrameLeases
+    int32_t rows;
+    int32_t cols;
+    int32_t type;
+    uint64_t step;
+    uint64_t frameNumber;           // 0 = no valid frame
+    int64_t capturedNs;
+};
+
+FrameLease::~FrameLease() {
+    release();
+}
+
+FrameLease::FrameLease(FrameLease&& other) noexcept {
+    *this = move(other);
+}
+
+FrameLease& FrameLease::operator=(FrameLease&& other) noexcept {
+    if (this != &other) {
+        release();
+        readers_ = exchange(other.readers_, nullptr);
+        frame_ = move(other.frame_);
+        frameNumber_ = other.frameNumber_;
+        capturedNs_ = other.capturedNs_;
+    }
+    return *this;
+}
+
+chrono::steady_clock::duration FrameLease::age() const {
+    return chrono::duration_cast<chrono::steady_clock::duration>(chrono::nanoseconds(nowNs() - capturedNs_));
+}
+
+void FrameLease::release() {
+    frame_.release();
+    if (readers_) {
+        readers_->fetch_sub(1);
+        readers_ = nullptr;
+    }
+}
+
+FrameRing::FrameRing(string name, void* base, size_t bytes, bool owner)
+    : name_(move(name)), base_(base), bytes_(bytes), owner_(owner) {}
+
+FrameRing::~FrameRing() {
+    if (writing_ >= 0) abortWrite();
+    munmap(base_, bytes_);
+    if (owner_) shm_unlink(name_.c_str());
+}
+
+unique_ptr<FrameRing> FrameRing::create(const string& name, int slots, size_t slotBytes) {
+    if (slots < 2 || slotBytes == 0) {
+        cerr << "[RING] " << name << ": need at least 2 slots and a non-zero slot size\n";
+        return nullptr;
+    }
+    size_t stride = alignUp(sizeof(Slot)) + alignUp(slotBytes);
+    size_t bytes = alignUp(sizeof(Header)) + stride * static_cast<size_t>(slots);
+
+    // A ring left behind by a crashed run has the same name; start fresh.
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        cerr << "[RING] shm_open " << name << " failed: " << strerror(errno) << "\n";
+        return nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        cerr << "[RING] Cannot size " << name << " to " << bytes << " bytes: " << strerror(errno) << "\n";
+        close(fd);
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        cerr << "[RING] mmap " << name << " failed: " << strerror(errno) << "\n";
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    unique_ptr<FrameRing> ring(new FrameRing(name, base, bytes, true));
+    Header* header = new (base) Header{};
+    header->magic = kRingMagic;
+    header->version = kRingVersion;
+    header->slotCount = static_cast<uint32_t>(slots);
+    header->slotBytes = slotBytes;
+    header->slotStride = stride;
+    header->lastFrameNs.store(nowNs());
+    for (int i = 0; i < slots; ++i) new (ring->slot(static_cast<uint32_t>(i))) Slot{};
+    return ring;
+}
+
+unique_ptr<FrameRing> FrameRing::attach(const string& name) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        cerr << "[RING] Cannot open " << name << ": " << strerror(errno) << "\n";
+        return nullptr;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+        cerr << "[RING] " << name << " is not a frame ring\n";
+        close(fd);
+        return nullptr;
+    }
+    size_t bytes = static_cast<size_t>(info.st_size);
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        cerr << "[RING] mmap " << name << " failed: " << strerror(errno) << "\n";
+        return nullptr;
+    }
+
+    const Header* header = static_cast<const Header*>(base);
+    size_t expected = alignUp(sizeof(Header)) + header->slotStride * header->slotCount;
+    if (header->magic != kRingMagic || header->version != kRingVersion || expected > bytes) {
+        cerr << "[RING] " << name << " has an unexpected layout\n";
+        munmap(base, bytes);
+        return nullptr;
+    }
+    return unique_ptr<FrameRing>(new FrameRing(name, base, bytes, false));
+}
+
+size_t FrameRing::slotBytes() const {
+    return static_cast<const Header*>(base_)->slotBytes;
+}
+
+FrameRing::Slot* FrameRing::slot(uint32_t index) const {
+    const Header* header = static_cast<const Header*>(base_);
+    return reinterpret_cast<Slot*>(static_cast<unsigned char*>(base_) + alignUp(sizeof(Header)) +
+                                   header->slotStride * index);
+}
+
+unsigned char* FrameRing::pixels(uint32_t index) const {
+    return reinterpret_cast<unsigned char*>(slot(index)) + alignUp(sizeof(Slot));
+}
+
+// The writer marks the slot odd first and only then checks for readers, while
+// acquireLatest() registers as a reader before checking the sequence. With
+// sequentially consistent atomics at least one of them sees the other, so a
+// leased slot is never written and an unfinished slot is never leased.
+bool FrameRing::claimSlot(uint32_t index) {
+    Slot* s = slot(index);
+    if (s->readers.load() != 0) return false;
+
+    uint64_t sequence = s->sequence.load();
+    // A slot left odd by a capture process that died mid-write is reclaimed
+    // with a fresh odd value.
+    uint64_t writing = (sequence & 1) ? sequence + 2 : sequence + 1;
+    s->sequence.store(writing);
+    if (s->readers.load() != 0) {
+        s->sequence.store(sequence);
+        return false;
+    }
+
+    writing_ = static_cast<int>(index);
+    writingSequence_ = writing;
+    return true;
+}
+
+void FrameRing::abortWrite() {
+    Slot* s = slot(static_cast<uint32_t>(writing_));
+    s->frameNumber = 0;
+    s->sequence.store(writingSequence_ + 1);
+    writing_ = -1;
+}
+
+cv::Mat FrameRing::beginWrite(cv::Size size, int type) {
+    if (writing_ >= 0) abortWrite();
+    if (size.area() <= 0 || static_cast<size_t>(size.area()) * CV_ELEM_SIZE(type) > slotBytes()) {
+        return cv::Mat();
+    }
+
+    // Any slot but the newest one: that one stays readable for the analyzer.
+    const Header* header = static_cast<const Header*>(base_);
+    uint32_t latest = header->latestSlot.load();
+    for (uint32_t step = 1; step < header->slotCount; ++step) {
+        uint32_t index = (latest + step) % header->slotCount;
+        if (claimSlot(index)) return cv::Mat(size, type, pixels(index));
+    }
+    return cv::Mat();
+}
+
+bool FrameRing::endWrite(const cv::Mat& frame) {
+    size_t frameBytes = frame.total() * frame.elemSize();
+    if (frame.empty() || frame.dims != 2 || frameBytes > slotBytes()) {
+        if (writing_ >= 0) abortWrite();
+        return false;
+    }
+
+    unsigned char* destination = writing_ >= 0 ? pixels(static_cast<uint32_t>(writing_)) : nullptr;
+    if (frame.data != destination) {
+        // The decoder allocated its own buffer (first frame or a new resolution).
+        if (writing_ >= 0) abortWrite();
+        cv::Mat target = beginWrite(frame.size(), frame.type());
+        if (target.empty()) return false;  // every other slot is leased: drop the frame
+        frame.copyTo(target);
+    }
+
+    Header* header = static_cast<Header*>(base_);
+    Slot* s = slot(static_cast<uint32_t>(writing_));
+    uint64_t frameNumber = header->published.load() + 1;
+    s->rows = frame.rows;
+    s->cols = frame.cols;
+    s->type = frame.type();
+    s->step = frame.cols * frame.elemSize();
+    s->frameNumber = frameNumber;
+    s->capturedNs = nowNs();
+    s->sequence.store(writingSequence_ + 1);
+
+    header->latestSlot.store(static_cast<uint32_t>(writing_));
+    header->published.store(frameNumber);
+    header->lastFrameNs.store(s->capturedNs);
+    writing_ = -1;
+    return true;
+}
+
+bool FrameRing::acquireLatest(FrameLease& lease, uint64_t afterFrame) {
+    lease.release();
+    Header* header = static_cast<Header*>(base_);
+
+    // The writer may reclaim the slot between reading latestSlot and taking
+    // the lease; it publishes a newer frame elsewhere, so just try again.
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        uint64_t newest = header->published.load();
+        if (newest == 0 || newest <= afterFrame) return false;
+
+        uint32_t index = header->latestSlot.load();
+        Slot* s = slot(index);
+        s->readers.fetch_add(1);
+        uint64_t sequence = s->sequence.load();
+        if ((sequence & 1) || s->frameNumber == 0 || s->frameNumber <= afterFrame) {
+            s->readers.fetch_sub(1);
+            continue;
+        }
+
+        lease.readers_ = &s->readers;
+        lease.frame_ = cv::Mat(s->rows, s->cols, s->type, pixels(index), s->step);
+        lease.frameNumber_ = s->frameNumber;
+        lease.capturedNs_ = s->capturedNs;
+        return true;
+    }
+    return false;
+}
+
+chrono::steady_clock::duration FrameRing::sinceLastFrame() const {
+    const Header* header = static_cast<const Header*>(base_);
+    return chrono::duration_cast<chrono::steady_clock::duration>(
+        chrono::nanoseconds(nowNs() - header->lastFrameNs.load()));
+}
@@ -3,27 +3,83 @@
 #include <opencv2/highgui.hpp>
 #include <opencv2/core.hpp>
 
+#include <iostream>
 #include <filesystem>
 #include <chrono>
 #include <utility>
 #include <string>
+#include <sstream>
+#include <vector>
 
+#include "ingest.hpp"
+#include "env_config.hpp"
 
-std::pair<std::string, std::string> ingest_camera() {
+static const char* kDefaultCameraUrl = "https://cameras.santoandre.sp.gov.br/coi02/ID_074";
+static const char* kDefaultAvenueName = "Avenida dos Estados";
+
+std::vector<CameraSource> load_camera_sources() {
+    std::vector<CameraSource> cameras;
+    std::stringstream entries(envString("TRAFFIC_CAMERAS", ""));
+    std::string entry;
+
+    while (std::getline(entries, entry, ';')) {
+        size_t sep = entry.find('|');
+        if (sep == std::string::npos || sep == 0 || sep + 1 == entry.size()) {
+            if (!entry.empty()) std::cerr << "[INGEST] Ignoring malformed camera entry: " << entry << "\n";
+            continue;
+        }
+        CameraSource camera{entry.substr(0, sep), entry.substr(sep + 1)};
+
+        // Optional mode after the URL: "Name|url|snapshot"
+        size_t mode = camera.url.rfind('|');
+        if (mode != std::string::npos) {
+            std::string flag = camera.url.substr(mode + 1);
+            camera.url.erase(mode);
+            if (flag == "snapshot") {
+                camera.snapshot = true;
+            } else {
+                std::cerr << "[INGEST] Unknown camera mode '" << flag << "' for " << camera.name << " (ignored)\n";
+            }
+        }
+        if (camera.url.empty()) {
+            std::cerr << "[INGEST] Ignoring malformed camera entry: " << entry << "\n";
+            continue;
+        }
+        cameras.push_back(camera);
+    }
+
+    if (cameras.empty()) {
+        cameras.push_back({kDefaultAvenueName, kDefaultCameraUrl});
+    }
+    return cameras;
+}
+
+bool capture_camera_frame(const CameraSource& camera, cv::Mat& frame) {
+    cv::VideoCapture cap(camera.url);
+    if (!cap.isOpened()) {
+        std::cerr << "[INGEST] Unable to open stream for " << camera.name << "\n";
+        return false;
+    }
+
+    cap >> frame;
+    cap.release();
+    if (frame.empty()) {
+        std::cerr << "[INGEST] Empty frame from " << camera.name << "\n";
+        return false;
+    }
+    return true;
+}
+
+std::pair<std::string, cv::Mat> ingest_camera_frame() {
     static bool first_time = true;  // Track first call
-    
-    const std::string url = "https://cameras.santoandre.sp.gov.br/coi02/ID_074";
-    const int camera_id = 074;
-    const std::string output_dir = "../resources/images/avenida_dos_estados";
-    const int interval_seconds = 20;
-    const std::string avenue_name = "Avenida dos Estados";
 
-    std::filesystem::create_directories(output_dir);
+    const std::string url = kDefaultCameraUrl;
+    const std::string avenue_name = kDefaultAvenueName;
 
     cv::VideoCapture cap(url);
     if (!cap.isOpened()) {
         std::cerr << "Error: Unable to open stream\n";
-        return {avenue_name, ""};
+        return {avenue_name, cv::Mat()};
     }
 
     cv::Mat frame;
@@ -52,7 +108,7 @@ std::pair<std::string, std::string> ingest_camera() {
             if (key == 'q' || key == 'Q') {
                 cap.release();
                 cv::destroyWindow("Camera Preview");
-                return {avenue_name, ""};
+                return {avenue_name, cv::Mat()};
             }
         }
 
@@ -64,10 +120,24 @@ std::pair<std::string, std::string> ingest_camera() {
         cap >> frame;  // just grab one frame immediately
         if (frame.empty()) {
             std::cerr << "Error: Empty frame\n";
-            return {avenue_name, ""};
         }
     }
 
+    cap.release();
+    return {avenue_name, frame};
+}
+
+std::pair<std::string, std::string> ingest_camera() {
+    const int camera_id = 074;
+    const std::string output_dir = "../resources/images/avenida_dos_estados";
+
+    auto [avenue_name, frame] = ingest_camera_frame();
+    if (frame.empty()) {
+        return {avenue_name, ""};
+    }
+
+    std::filesystem::create_directories(output_dir);
+
     // Save the captured frame
     long ts = std::chrono::duration_cast<std::chrono::seconds>(
                   std::chrono::system_clock::now().time_since_epoch())
@@ -78,7 +148,6 @@ std::pair<std::string, std::string> ingest_camera() {
         std::to_string(ts) + ".jpg";
 
     cv::imwrite(filename, frame);
-    cap.release();
 
     return {avenue_name, filename};
 }
@@ -0,0 +1,690 @@
+#include "snapshot_fetcher.hpp"
+#include "env_config.hpp"
+#include "thread_budget.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+// Marks the eventfd used by stop() to interrupt epoll_wait().
+static const uint64_t kWakeToken = UINT64_MAX;
+
+// chunkRemaining values while no chunk data is being read.
+static const long long kChunkSizeLine = -1;
+static const long long kChunkDataEnd = -2;     // CRLF after the chunk data
+static const long long kChunkTrailers = -3;    // after the last (zero) chunk
+
+static const size_t kMaxHeaderBytes = 64 * 1024;
+static const size_t kMaxLatencySamples = 1024;
+
+FetcherConfig FetcherConfig::fromEnv() {
+    FetcherConfig config;
+    config.enabled = envInt("FETCH_SNAPSHOTS", config.enabled ? 1 : 0) != 0;
+    config.interval = chrono::milliseconds(max(10L, envInt("FETCH_INTERVAL_MS", config.interval.count())));
+    config.timeout = chrono::milliseconds(max(100L, envInt("FETCH_TIMEOUT_MS", config.timeout.count())));
+    config.staleAfter = chrono::seconds(max(1L, envInt("FETCH_STALE_SECONDS", config.staleAfter.count())));
+    config.maxInFlight = max(1, static_cast<int>(envInt("FETCH_MAX_IN_FLIGHT", config.maxInFlight)));
+    config.decodeWorkers = max(1, static_cast<int>(envInt("FETCH_DECODE_WORKERS", config.decodeWorkers)));
+    config.maxBodyBytes = static_cast<size_t>(max(1L, envInt("FETCH_MAX_BODY_MB", static_cast<long>(config.maxBodyBytes >> 20)))) << 20;
+    return config;
+}
+
+static string lowercase(string text) {
+    transform(text.begin(), text.end(), text.begin(), ::tolower);
+    return text;
+}
+
+static double percentile(vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    size_t index = min(values.size() - 1, static_cast<size_t>(p * (values.size() - 1) + 0.5));
+    nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+static string percentDecode(const string& text) {
+    string out;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '%' && i + 2 < text.size() && isxdigit(static_cast<unsigned char>(text[i + 1])) &&
+            isxdigit(static_cast<unsigned char>(text[i + 2]))) {
+            out += static_cast<char>(stoi(text.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        } else {
+            out += text[i];
+        }
+    }
+    return out;
+}
+
+static string base64(const string& data) {
+    static const char* kAlphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    string out;
+    for (size_t i = 0; i < data.size(); i += 3) {
+        uint32_t chunk = static_cast<unsigned char>(data[i]) << 16;
+        if (i + 1 < data.size()) chunk |= static_cast<unsigned char>(data[i + 1]) << 8;
+        if (i + 2 < data.size()) chunk |= static_cast<unsigned char>(data[i + 2]);
+        out += kAlphabet[(chunk >> 18) & 63];
+        out += kAlphabet[(chunk >> 12) & 63];
+        out += i + 1 < data.size() ? kAlphabet[(chunk >> 6) & 63] : '=';
+        out += i + 2 < data.size() ? kAlphabet[chunk & 63] : '=';
+    }
+    return out;
+}
+
+bool SnapshotFetcher::supports(const string& url) {
+    return lowercase(url.substr(0, 7)) == "http://";
+}
+
+SnapshotFetcher::SnapshotFetcher(FetcherConfig config, vector<CameraSource> cameras) : config_(move(config)) {
+    for (CameraSource& source : cameras) {
+        auto camera = make_unique<Camera>();
+        camera->source = move(source);
+
+        // http://[user:pass@]host[:port][/path], host may be a bracketed IPv6 literal
+        string rest = camera->source.url.size() > 7 ? camera->source.url.substr(7) : "";
+        size_t slash = rest.find_first_of("/?");
+        string authority = rest.substr(0, slash);
+        string path = slash == string::npos ? "/" : rest.substr(slash);
+        if (path[0] == '?') path.insert(0, "/");
+
+        string credentials;
+        size_t at = authority.rfind('@');
+        if (at != string::npos) {
+            credentials = percentDecode(authority.substr(0, at));
+            authority.erase(0, at + 1);
+        }
+
+        string port;
+        if (!authority.empty() && authority[0] == '[') {
+            size_t close = authority.find(']');
+            if (close != string::npos) {
+                camera->host = authority.substr(1, close - 1);
+                if (close + 1 < authority.size() && authority[close + 1] == ':') port = authority.substr(close + 2);
+            }
+        } else {
+            size_t colon = authority.rfind(':');
+            camera->host = authority.substr(0, colon);
+            if (colon != string::npos) port = authority.substr(colon + 1);
+        }
+        camera->port = port.empty() ? "80" : port;
+        if (camera->host.empty()) {
+            // Left unresolvable: the camera fails every fetch with this error.
+            cerr << "[FETCH] " << camera->source.name << ": cannot parse the host of its URL\n";
+        }
+
+        camera->request = "GET " + path + " HTTP/1.1\r\n"
+                          "Host: " + authority + "\r\n";
+        if (!credentials.empty()) camera->request += "Authorization: Basic " + base64(credentials) + "\r\n";
+        camera->request += "User-Agent: traffic_density\r\n"
+                           "Accept: image/jpeg, image/*\r\n"
+                           "Connection: keep-alive\r\n\r\n";
+        cameras_.push_back(move(camera));
+    }
+}
+
+SnapshotFetcher::~SnapshotFetcher() {
+    stop();
+}
+
+bool SnapshotFetcher::start() {
+    if (running_) return true;
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0) {
+        cerr << "[FETCH] Cannot create event loop: " << strerror(errno) << "\n";
+        if (epollFd_ >= 0) close(epollFd_);
+        if (wakeFd_ >= 0) close(wakeFd_);
+        epollFd_ = wakeFd_ = -1;
+        return false;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = kWakeToken;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event);
+
+    // Spread the first requests over one interval instead of firing them all at once.
+    auto now = Clock::now();
+    for (size_t i = 0; i < cameras_.size(); ++i) {
+        cameras_[i]->nextFetchAt = now + config_.interval * i / max<size_t>(1, cameras_.size());
+    }
+
+    running_ = true;
+    loop_ = thread(&SnapshotFetcher::loop, this);
+    for (int i = 0; i < config_.decodeWorkers; ++i) decoders_.emplace_back(&SnapshotFetcher::decodeLoop, this);
+
+    cout << "[FETCH] Polling " << cameras_.size() << " snapshot camera(s) at most every "
+         << config_.interval.count() << " ms with " << config_.decodeWorkers << " decoder(s)\n";
+    return true;
+}
+
+void SnapshotFetcher::stop() {
+    {
+        // Under the lock, so a decoder between its predicate check and its
+        // wait cannot miss the notification below.
+        lock_guard<mutex> lock(mutex_);
+        if (!running_) return;
+        running_ = false;
+    }
+
+    // Without the wakeup the loop still notices running_ within a second.
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = write(wakeFd_, &one, sizeof(one));
+    if (loop_.joinable()) loop_.join();
+
+    decodeCv_.notify_all();
+    for (thread& decoder : decoders_) decoder.join();
+    decoders_.clear();
+
+    for (auto& camera : cameras_) closeConnection(*camera);
+    close(wakeFd_);
+    close(epollFd_);
+    wakeFd_ = epollFd_ = -1;
+}
+
+bool SnapshotFetcher::latestFrame(size_t index, cv::Mat& frame, uint64_t& sequence) {
+    if (index >= cameras_.size()) return false;
+    lock_guard<mutex> lock(mutex_);
+    Camera& camera = *cameras_[index];
+    if (camera.frame.empty() || Clock::now() - camera.frameAt > config_.staleAfter) return false;
+    frame = camera.frame;
+    sequence = camera.frameSequence;
+    return true;
+}
+
+void SnapshotFetcher::setInterval(size_t index, chrono::milliseconds interval) {
+    if (index >= cameras_.size()) return;
+    cameras_[index]->samplingIntervalMs.store(max<long long>(1, interval.count()));
+    // A shorter interval may make the camera due right away.
+    if (running_) {
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t written = write(wakeFd_, &one, sizeof(one));
+    }
+}
+
+// Two fetches per sampling interval keep the frame a job picks up at most half
+// an interval old without polling quiet cameras every second.
+Clock::time_point SnapshotFetcher::fetchDue(const Camera& camera) const {
+    long long samplingMs = camera.samplingIntervalMs.load();
+    chrono::milliseconds period = samplingMs > 0 ? max(config_.interval, chrono::milliseconds(samplingMs / 2))
+                                                 : config_.interval;
+    return max(camera.nextFetchAt, camera.startedAt + period);
+}
+
+void SnapshotFetcher::loop() {
+    vector<epoll_event> events(256);
+
+    while (running_) {
+        auto now = Clock::now();
+        auto wake = now + chrono::seconds(1);
+        bool waiting = false;   // a camera is due but every request slot is taken
+
+        for (size_t i = 0; i < cameras_.size(); ++i) {
+            Camera& camera = *cameras_[i];
+            if (camera.state != State::Idle && now >= camera.deadline) {
+                fail(i, "timed out", true);
+            }
+            auto due = fetchDue(camera);
+            if (camera.state == State::Idle && now >= due) {
+                if (inFlight_ < config_.maxInFlight) startFetch(i, now);
+                else waiting = true;
+            }
+            if (camera.state != State::Idle) wake = min(wake, camera.deadline);
+            else if (due > now) wake = min(wake, due);
+        }
+
+        // Due cameras get the next free slot; completions wake the loop anyway.
+        if (waiting && inFlight_ < config_.maxInFlight) wake = now;
+        int timeoutMs = static_cast<int>(chrono::duration_cast<chrono::milliseconds>(wake - Clock::now()).count());
+        int ready = epoll_wait(epollFd_, events.data(), static_cast<int>(events.size()), max(0, timeoutMs) + 1);
+        if (ready < 0 && errno != EINTR) {
+            cerr << "[FETCH] epoll_wait failed: " << strerror(errno) << "\n";
+            break;
+        }
+        for (int e = 0; e < ready; ++e) {
+            if (events[e].data.u64 == kWakeToken) {
+                uint64_t value;
+                [[maybe_unused]] ssize_t drained = read(wakeFd_, &value, sizeof(value));
+                continue;
+            }
+            handleEvent(static_cast<size_t>(events[e].data.u64), events[e].events);
+        }
+    }
+}
+
+void SnapshotFetcher::startFetch(size_t index, Clock::time_point now) {
+    Camera& camera = *cameras_[index];
+    camera.startedAt = now;
+    camera.deadline = now + config_.timeout;
+    camera.nextFetchAt = now + config_.interval;
+    camera.buffer.clear();
+    camera.body.clear();
+    camera.sent = 0;
+    camera.contentLength = -1;
+    camera.chunked = false;
+    camera.chunkRemaining = kChunkSizeLine;
+    camera.keepAlive = true;
+    inFlight_++;
+
+    if (camera.fd >= 0) {
+        camera.reused = true;
+        camera.state = State::Sending;
+        if (!sendRequest(camera, index) && !retryOnFreshConnection(index)) {
+            fail(index, string("send failed: ") + strerror(errno));
+        }
+        return;
+    }
+
+    camera.reused = false;
+    camera.state = State::Connecting;
+    if (!openConnection(camera, index)) {
+        if (camera.host.empty()) fail(index, "malformed URL");
+        else fail(index, camera.addressLength == 0 ? "cannot resolve " + camera.host
+                                                   : string("connect failed: ") + strerror(errno));
+    }
+}
+
+bool SnapshotFetcher::openConnection(Camera& camera, size_t index) {
+    if (camera.addressLength == 0) {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        int status = getaddrinfo(camera.host.c_str(), camera.port.c_str(), &hints, &result);
+        if (status != 0 || !result) return false;  // addressLength stays 0
+        memcpy(&camera.address, result->ai_addr, result->ai_addrlen);
+        camera.addressLength = result->ai_addrlen;
+        freeaddrinfo(result);
+    }
+
+    int fd = socket(camera.address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    int status = connect(fd, reinterpret_cast<sockaddr*>(&camera.address), camera.addressLength);
+    if (status != 0 && errno != EINPROGRESS) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return false;
+    }
+
+    camera.fd = fd;
+    epoll_event event{};
+    event.events = EPOLLOUT;
+    event.data.u64 = index;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event);
+    camera.state = status == 0 ? State::Sending : State::Connecting;
+    if (camera.state == State::Sending) return sendRequest(camera, index);
+    return true;
+}
+
+void SnapshotFetcher::watch(Camera& camera, size_t index, uint32_t events) {
+    epoll_event event{};
+    event.events = events;
+    event.data.u64 = index;
+    epoll_ctl(epollFd_, EPOLL_CTL_MOD, camera.fd, &event);
+}
+
+void SnapshotFetcher::closeConnection(Camera& camera) {
+    if (camera.fd < 0) return;
+    close(camera.fd);  // also removes it from the epoll set
+    camera.fd = -1;
+}
+
+// Servers close idle keep-alive connections whenever they like; if that
+// happened before the request got an answer, retry once on a new connection.
+bool SnapshotFetcher::retryOnFreshConnection(size_t index) {
+    Camera& camera = *cameras_[index];
+    if (!camera.reused || !camera.buffer.empty() || !camera.body.empty() ||
+        camera.state == State::ReadingBody) {
+        return false;
+    }
+    closeConnection(camera);
+    camera.reused = false;
+    camera.sent = 0;
+    return openConnection(camera, index);
+}
+
+void SnapshotFetcher::handleEvent(size_t index, uint32_t events) {
+    if (index >= cameras_.size()) return;
+    Camera& camera = *cameras_[index];
+
+    if (camera.state == State::Idle) {
+        // Readable idle connection: the server closed it (or sent junk).
+        closeConnection(camera);
+        return;
+    }
+
+    if (camera.state == State::Connecting) {
+        if (!(events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) return;
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(camera.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+        if (error != 0) {
+            camera.addressLength = 0;
+            fail(index, string("connect failed: ") + strerror(error));
+            return;
+        }
+        camera.state = State::Sending;
+    }
+
+    if (camera.state == State::Sending) {
+        if (!sendRequest(camera, index)) {
+            if (!retryOnFreshConnection(index)) fail(index, string("send failed: ") + strerror(errno));
+        }
+        return;
+    }
+
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        bool complete = false;
+        string error;
+        if (!readResponse(camera, complete, error)) {
+            if (!retryOnFreshConnection(index)) fail(index, error);
+        } else if (complete) {
+            finish(index);
+        }
+    }
+}
+
+bool SnapshotFetcher::sendRequest(Camera& camera, size_t index) {
+    while (camera.sent < camera.request.size()) {
+        ssize_t sent = send(camera.fd, camera.request.data() + camera.sent,
+                            camera.request.size() - camera.sent, MSG_NOSIGNAL);
+        if (sent > 0) {
+            camera.sent += static_cast<size_t>(sent);
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            watch(camera, index, EPOLLOUT);
+            return true;
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return false;
+        }
+    }
+    camera.state = State::ReadingHeaders;
+    watch(camera, index, EPOLLIN | EPOLLRDHUP);
+    return true;
+}
+
+bool SnapshotFetcher::readResponse(Camera& camera, bool& complete, string& error) {
+    char chunk[64 * 1024];
+    while (true) {
+        ssize_t received = recv(camera.fd, chunk, sizeof(chunk), 0);
+        if (received > 0) {
+            camera.buffer.append(chunk, static_cast<size_t>(received));
+            if (camera.state == State::ReadingHeaders && !parseHeaders(camera, error)) return false;
+            if (camera.state == State::ReadingBody && !consumeBody(camera, complete, error)) return false;
+            if (complete) return true;
+            continue;
+        }
+        if (received == 0) {
+            // Without Content-Length or chunking the body ends with the connection.
+            if (camera.state == State::ReadingBody && camera.contentLength < 0 && !camera.chunked) {
+                camera.keepAlive = false;
+                complete = true;
+                return true;
+            }
+            error = "connection closed by camera";
+            return false;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+        if (errno == EINTR) continue;
+        error = string("receive failed: ") + strerror(errno);
+        return false;
+    }
+}
+
+bool SnapshotFetcher::parseHeaders(Camera& camera, string& error) {
+    size_t end = camera.buffer.find("\r\n\r\n");
+    if (end == string::npos) {
+        if (camera.buffer.size() > kMaxHeaderBytes) {
+            error = "response headers too large";
+            return false;
+        }
+        return true;
+    }
+
+    istringstream headers(camera.buffer.substr(0, end));
+    camera.buffer.erase(0, end + 4);
+
+    string version;
+    int status = 0;
+    string line;
+    getline(headers, line);
+    istringstream(line) >> version >> status;
+    if (status != 200) {
+        error = "HTTP " + to_string(status);
+        return false;
+    }
+    camera.keepAlive = version != "HTTP/1.0";
+
+    while (getline(headers, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t colon = line.find(':');
+        if (colon == string::npos) continue;
+        string name = lowercase(line.substr(0, colon));
+        string value = line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(" \t"));
+        string lowered = lowercase(value);
+
+        if (name == "content-length") {
+            camera.contentLength = atoll(value.c_str());
+        } else if (name == "transfer-encoding" && lowered.find("chunked") != string::npos) {
+            camera.chunked = true;
+        } else if (name == "connection") {
+            if (lowered.find("close") != string::npos) camera.keepAlive = false;
+            if (lowered.find("keep-alive") != string::npos) camera.keepAlive = true;
+        } else if (name == "content-type" && lowered.rfind("multipart/", 0) == 0) {
+            error = "continuous stream, not a snapshot (drop the |snapshot marker for this camera)";
+            return false;
+        }
+    }
+    if (camera.chunked) camera.contentLength = -1;
+    if (camera.contentLength > static_cast<long long>(config_.maxBodyBytes)) {
+        error = "image larger than FETCH_MAX_BODY_MB";
+        return false;
+    }
+    if (camera.contentLength > 0) camera.body.reserve(static_cast<size_t>(camera.contentLength));
+    camera.state = State::ReadingBody;
+    return true;
+}
+
+bool SnapshotFetcher::consumeBody(Camera& camera, bool& complete, string& error) {
+    string& buffer = camera.buffer;
+
+    if (!camera.chunked) {
+        size_t take = buffer.size();
+        if (camera.contentLength >= 0) {
+            take = min(take, static_cast<size_t>(camera.contentLength) - camera.body.size());
+        }
+        camera.body.insert(camera.body.end(), buffer.begin(), buffer.begin() + take);
+        buffer.erase(0, take);
+        if (camera.body.size() > config_.maxBodyBytes) {
+            error = "image larger than FETCH_MAX_BODY_MB";
+            return false;
+        }
+        complete = camera.contentLength >= 0 && camera.body.size() == static_cast<size_t>(camera.contentLength);
+        return true;
+    }
+
+    while (true) {
+        if (camera.chunkRemaining > 0) {
+            size_t take = min(buffer.size(), static_cast<size_t>(camera.chunkRemaining));
+            camera.body.insert(camera.body.end(), buffer.begin(), buffer.begin() + take);
+            buffer.erase(0, take);
+            camera.chunkRemaining -= static_cast<long long>(take);
+            if (camera.body.size() > config_.maxBodyBytes) {
+                error = "image larger than FETCH_MAX_BODY_MB";
+                return false;
+            }
+            if (camera.chunkRemaining > 0) return true;  // need more data
+            camera.chunkRemaining = kChunkDataEnd;
+        }
+
+        size_t lineEnd = buffer.find("\r\n");
+        if (lineEnd == string::npos) {
+            if (buffer.size() > kMaxHeaderBytes) {
+                error = "malformed chunked body";
+                return false;
+            }
+            return true;
+        }
+        string line = buffer.substr(0, lineEnd);
+        buffer.erase(0, lineEnd + 2);
+
+        if (camera.chunkRemaining == kChunkDataEnd) {
+            camera.chunkRemaining = kChunkSizeLine;
+        } else if (camera.chunkRemaining == kChunkSizeLine) {
+            char* parsedEnd = nullptr;
+            long long size = strtoll(line.c_str(), &parsedEnd, 16);
+            if (parsedEnd == line.c_str() || size < 0) {
+                error = "malformed chunked body";
+                return false;
+            }
+            camera.chunkRemaining = size == 0 ? kChunkTrailers : size;
+        } else if (line.empty()) {
+            // Blank line after the last chunk (and any trailers): done.
+            complete = true;
+            return true;
+        }
+    }
+}
+
+void SnapshotFetcher::finish(size_t index) {
+    Camera& camera = *cameras_[index];
+    inFlight_--;
+    camera.state = State::Idle;
+    camera.consecutiveFailures = 0;
+    if (camera.keepAlive) {
+        watch(camera, index, EPOLLIN | EPOLLRDHUP);
+    } else {
+        closeConnection(camera);
+    }
+
+    double latencyMs = chrono::duration<double, milli>(Clock::now() - camera.startedAt).count();
+    lock_guard<mutex> lock(mutex_);
+    camera.fetched++;
+    camera.bytes += camera.body.size();
+    if (camera.latencyMs.size() < kMaxLatencySamples) camera.latencyMs.push_back(latencyMs);
+
+    // Replaces a body the decoders have not picked up yet.
+    camera.pendingBody.swap(camera.body);
+    camera.pendingSequence = ++camera.sequence;
+    if (!camera.queued) {
+        camera.queued = true;
+        decodeQueue_.push_back(index);
+        decodeCv_.notify_one();
+    }
+}
+
+void SnapshotFetcher::fail(size_t index, const string& error, bool timedOut) {
+    Camera& camera = *cameras_[index];
+    if (camera.state == State::Idle) return;
+    inFlight_--;
+    camera.state = State::Idle;
+    closeConnection(camera);
+    if (!timedOut && error.rfind("HTTP ", 0) != 0) camera.addressLength = 0;  // resolve again next time
+
+    // Back off exponentially (up to 32 intervals) while a camera keeps failing.
+    camera.consecutiveFailures++;
+    int shift = min(camera.consecutiveFailures - 1, 5);
+    camera.nextFetchAt = max(camera.nextFetchAt, Clock::now() + config_.interval * (1 << shift));
+
+    lock_guard<mutex> lock(mutex_);
+    camera.failed++;
+    if (timedOut) camera.timeouts++;
+    camera.lastError = error;
+}
+
+void SnapshotFetcher::decodeLoop() {
+    unique_lock<mutex> lock(mutex_);
+    while (true) {
+        decodeCv_.wait(lock, [this] { return !running_ || !decodeQueue_.empty(); });
+        if (!running_) return;
+
+        size_t index = decodeQueue_.front();
+        decodeQueue_.pop_front();
+        Camera& camera = *cameras_[index];
+        vector<unsigned char> body;
+        body.swap(camera.pendingBody);
+        uint64_t sequence = camera.pendingSequence;
+        camera.queued = false;
+        lock.unlock();
+
+        cv::Mat frame;
+        {
+            ThreadBudget::Scope scope(WorkerRole::Capture);
+            try {
+                frame = cv::imdecode(body, cv::IMREAD_COLOR);
+            } catch (const cv::Exception&) {
+                frame.release();
+            }
+        }
+
+        lock.lock();
+        if (frame.empty()) {
+            camera.decodeFailures++;
+            camera.lastError = "undecodable image";
+        } else if (sequence > camera.frameSequence) {
+            // Two decoders may race on one camera; keep the newer frame.
+            camera.frame = frame;
+            camera.frameSequence = sequence;
+            camera.frameAt = Clock::now();
+        }
+    }
+}
+
+string SnapshotFetcher::summary() {
+    lock_guard<mutex> lock(mutex_);
+    uint64_t fetched = 0, failed = 0, timeouts = 0, decodeFailures = 0, bytes = 0;
+    vector<double> latencies;
+    ostringstream failures;
+    failures << fixed << setprecision(1);
+
+    for (auto& pointer : cameras_) {
+        Camera& camera = *pointer;
+        fetched += camera.fetched;
+        failed += camera.failed;
+        timeouts += camera.timeouts;
+        decodeFailures += camera.decodeFailures;
+        bytes += camera.bytes;
+        latencies.insert(latencies.end(), camera.latencyMs.begin(), camera.latencyMs.end());
+
+        if (camera.failed > 0 || camera.decodeFailures > 0) {
+            failures << "[FETCH]   " << camera.source.name << ": ok=" << camera.fetched
+                     << " failed=" << camera.failed << " timeouts=" << camera.timeouts
+                     << " undecodable=" << camera.decodeFailures
+                     << " p50=" << percentile(camera.latencyMs, 0.50) << "ms"
+                     << " last_error=\"" << camera.lastError << "\"\n";
+        }
+        camera.fetched = camera.failed = camera.timeouts = camera.decodeFailures = camera.bytes = 0;
+        camera.latencyMs.clear();
+    }
+
+    ostringstream out;
+    out << fixed << setprecision(1)
+        << "[FETCH] " << cameras_.size() << " cameras: ok=" << fetched << " failed=" << failed
+        << " timeouts=" << timeouts << " undecodable=" << decodeFailures
+        << " received=" << bytes / 1024.0 / 1024.0 << "MB"
+        << " latency p50=" << percentile(latencies, 0.50) << "ms"
+        << " p95=" << percentile(latencies, 0.95) << "ms"
+        << " p99=" << percentile(latencies, 0.99) << "ms\n"
+        << failures.str();
+    return out.str();
+}
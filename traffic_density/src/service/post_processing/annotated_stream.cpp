@@ -0,0 +1,99 @@
+#include "annotated_stream.hpp"
+#include "debug_frame.hpp"
+#include "env_config.hpp"
+#include "slug.hpp"
+
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+StreamConfig StreamConfig::fromEnv() {
+    StreamConfig config;
+    config.port = static_cast<int>(envInt("STREAM_PORT", config.port));
+    config.bindAddress = envString("STREAM_BIND", config.bindAddress);
+    config.jpegQuality = static_cast<int>(clamp(envInt("STREAM_JPEG_QUALITY", config.jpegQuality), 1L, 100L));
+    config.grid = envInt("STREAM_GRID", config.grid ? 1 : 0) != 0;
+    config.gridStep = max(10, static_cast<int>(envInt("STREAM_GRID_STEP", config.gridStep)));
+    return config;
+}
+
+AnnotatedStream::AnnotatedStream(StreamConfig config) : config_(config), server_(config.port, config.bindAddress) {}
+
+AnnotatedStream::~AnnotatedStream() {
+    stop();
+}
+
+bool AnnotatedStream::start() {
+    if (config_.port <= 0) return false;
+    enabled_ = server_.start();
+    return enabled_;
+}
+
+void AnnotatedStream::stop() {
+    server_.stop();
+    enabled_ = false;
+}
+
+bool AnnotatedStream::watching(const string& camera) const {
+    return enabled_ && server_.clientCount(slugify(camera)) > 0;
+}
+
+void AnnotatedStream::publish(const string& camera, const Mat& frame, const TrafficAnalysis& analysis) {
+    if (!enabled_ || frame.empty()) return;
+
+    server_.publishLazy(slugify(camera), [this, frame, analysis]() -> JpegBuffer {
+        Mat image = frame.clone();
+        drawTrafficAnalysis(image, analysis);
+
+        if (config_.grid) {
+            auto grid = gridLayer(image.size());
+            grid->pixels.copyTo(image, grid->mask);
+        }
+
+        ostringstream status;
+        status << analysis.vehicleCount << " vehicles | density "
+               << fixed << setprecision(3) << analysis.density << " | " << analysis.condition;
+        putText(image, status.str(), Point(10, image.rows - 12),
+                FONT_HERSHEY_SIMPLEX, 0.7, Scalar(0, 255, 255), 2);
+
+        return encode(image);
+    });
+}
+
+void AnnotatedStream::publishComparison(const string& camera, const Mat& original, const Mat& processed) {
+    if (!enabled_ || original.empty() || processed.empty()) return;
+
+    server_.publishLazy(slugify(camera) + "_compare", [this, original, processed]() -> JpegBuffer {
+        Mat combined;
+        hconcat(original, processed, combined);
+        return encode(combined);
+    });
+}
+
+shared_ptr<const AnnotatedStream::GridLayer> AnnotatedStream::gridLayer(Size size) {
+    lock_guard<mutex> lock(gridMutex_);
+    auto key = make_pair(size.width, size.height);
+    auto it = gridCache_.find(key);
+    if (it != gridCache_.end()) return it->second;
+
+    auto layer = make_shared<GridLayer>();
+    layer->pixels = Mat::zeros(size, CV_8UC3);
+    drawDebugGrid(layer->pixels, config_.gridStep);
+
+    Mat gray;
+    cvtColor(layer->pixels, gray, COLOR_BGR2GRAY);
+    layer->mask = gray > 0;
+
+    gridCache_[key] = layer;
+    return layer;
+}
+
+JpegBuffer AnnotatedStream::encode(const Mat& image) const {
+    auto jpeg = make_shared<vector<uchar>>();
+    vector<int> params = {IMWRITE_JPEG_QUALITY, config_.jpegQuality};
+    if (!imencode(".jpg", image, *jpeg, params)) return nullptr;
+    return jpeg;
+}
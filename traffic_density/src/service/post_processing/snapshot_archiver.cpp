@@ -0,0 +1,164 @@
+#include "snapshot_archiver.hpp"
+#include "env_config.hpp"
+#include "slug.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <system_error>
+#include <vector>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+ArchiverConfig ArchiverConfig::fromEnv() {
+    ArchiverConfig config;
+    config.rootDir = envString("ARCHIVE_DIR", config.rootDir);
+    config.queueCapacity = static_cast<size_t>(max(1L, envInt("ARCHIVE_QUEUE_CAPACITY", static_cast<long>(config.queueCapacity))));
+    config.jpegQuality = static_cast<int>(clamp(envInt("ARCHIVE_JPEG_QUALITY", config.jpegQuality), 1L, 100L));
+    config.quotaBytesPerCamera = static_cast<uint64_t>(max(0L, envInt("ARCHIVE_QUOTA_MB", static_cast<long>(config.quotaBytesPerCamera >> 20)))) << 20;
+    config.heartbeat = chrono::seconds(max(0L, envInt("ARCHIVE_HEARTBEAT_SECONDS", config.heartbeat.count())));
+    return config;
+}
+
+SnapshotArchiver::SnapshotArchiver(ArchiverConfig config) : config_(move(config)) {}
+
+SnapshotArchiver::~SnapshotArchiver() {
+    stop();
+}
+
+void SnapshotArchiver::start() {
+    lock_guard<mutex> lock(mutex_);
+    if (running_ || config_.quotaBytesPerCamera == 0) return;
+    running_ = true;
+    writer_ = thread(&SnapshotArchiver::writerLoop, this);
+}
+
+void SnapshotArchiver::stop() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!running_) return;
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (writer_.joinable()) writer_.join();
+}
+
+bool SnapshotArchiver::offer(const string& camera, const string& condition, const cv::Mat& frame) {
+    if (frame.empty()) return false;
+    auto now = chrono::steady_clock::now();
+
+    lock_guard<mutex> lock(mutex_);
+    if (!running_) return false;
+
+    PolicyState& state = policy_[camera];
+    bool transition = !state.seen || state.lastCondition != condition;
+    bool heartbeat = config_.heartbeat.count() > 0 && (now - state.lastArchived) >= config_.heartbeat;
+    if (!transition && !heartbeat) return false;
+
+    if (queue_.size() >= config_.queueCapacity) {
+        // Never wait for the disk. The policy state is left alone, so the
+        // next frame of this condition is still treated as the transition.
+        dropped_++;
+        return false;
+    }
+
+    state.seen = true;
+    state.lastCondition = condition;
+    state.lastArchived = now;
+    queue_.push_back({camera, slugify(condition), frame.clone(), chrono::system_clock::now()});
+    cv_.notify_one();
+    return true;
+}
+
+uint64_t SnapshotArchiver::written() const {
+    lock_guard<mutex> lock(mutex_);
+    return written_;
+}
+
+uint64_t SnapshotArchiver::dropped() const {
+    lock_guard<mutex> lock(mutex_);
+    return dropped_;
+}
+
+void SnapshotArchiver::writerLoop() {
+    unique_lock<mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return !running_ || !queue_.empty(); });
+        if (queue_.empty()) return;  // stopped and flushed
+
+        Snapshot snapshot = move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        write(snapshot);
+
+        lock.lock();
+    }
+}
+
+SnapshotArchiver::CameraDir& SnapshotArchiver::cameraDir(const string& camera) {
+    auto it = dirs_.find(camera);
+    if (it != dirs_.end()) return it->second;
+
+    CameraDir& dir = dirs_[camera];
+    dir.dir = fs::path(config_.rootDir) / slugify(camera);
+    error_code ec;
+    fs::create_directories(dir.dir, ec);
+
+    // Pick up snapshots left by previous runs so the quota covers them too.
+    vector<pair<fs::file_time_type, pair<fs::path, uint64_t>>> existing;
+    for (const auto& entry : fs::directory_iterator(dir.dir, ec)) {
+        if (!entry.is_regular_file(ec)) continue;
+        if (entry.path().filename().string().rfind("snapshot_", 0) != 0) continue;
+        existing.push_back({entry.last_write_time(ec), {entry.path(), entry.file_size(ec)}});
+    }
+    sort(existing.begin(), existing.end(),
+         [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (auto& file : existing) {
+        dir.bytes += file.second.second;
+        dir.files.push_back(move(file.second));
+    }
+    return dir;
+}
+
+void SnapshotArchiver::write(const Snapshot& snapshot) {
+    CameraDir& dir = cameraDir(snapshot.camera);
+
+    long long ms = chrono::duration_cast<chrono::milliseconds>(
+                       snapshot.capturedAt.time_since_epoch()).count();
+    fs::path path = dir.dir / ("snapshot_" + to_string(ms) + "_" + snapshot.tag + ".jpg");
+
+    vector<int> params = {cv::IMWRITE_JPEG_QUALITY, config_.jpegQuality};
+    try {
+        if (!cv::imwrite(path.string(), snapshot.frame, params)) {
+            cerr << "[ARCHIVE] Failed to write " << path << "\n";
+            return;
+        }
+    } catch (const cv::Exception& e) {
+        cerr << "[ARCHIVE] OpenCV exception writing " << path << ": " << e.what() << "\n";
+        return;
+    }
+
+    error_code ec;
+    uint64_t size = fs::file_size(path, ec);
+    if (ec) size = 0;
+    dir.files.push_back({path, size});
+    dir.bytes += size;
+    enforceQuota(dir);
+
+    lock_guard<mutex> lock(mutex_);
+    written_++;
+}
+
+void SnapshotArchiver::enforceQuota(CameraDir& dir) {
+    // Keep at least the snapshot just written, even if it alone exceeds the quota.
+    while (dir.bytes > config_.quotaBytesPerCamera && dir.files.size() > 1) {
+        auto [oldest, size] = dir.files.front();
+        dir.files.pop_front();
+        dir.bytes -= min(size, dir.bytes);
+
+        error_code ec;
+        fs::remove(oldest, ec);
+        if (ec) cerr << "[ARCHIVE] Failed to evict " << oldest << ": " << ec.message() << "\n";
+    }
+}
@@ -7,6 +7,8 @@
 #include <filesystem>
 #include <string>
 
+#include "pre_processing.hpp"
+
 using namespace cv;
 using namespace std;
 
@@ -35,11 +37,24 @@ Mat apply_bilateral_filter(const Mat& frame) {
     return result;
 }
 
-// Update preprocess_static to accept avenue_name
-std::string preprocess_static(const Mat& frame, const std::string& avenue_name) {
+// In-memory preprocessing used by the scheduled live pipeline
+Mat preprocess_frame(const Mat& frame) {
     Mat result = apply_clahe_hsv(frame);
     result = apply_bilateral_filter(result);
     // result = apply_roi(result); // Uncomment if ROI is needed
+    return result;
+}
+
+// Side-by-side comparison window
+void show_preprocessing(const Mat& original, const Mat& processed) {
+    Mat combined;
+    hconcat(original, processed, combined);
+    imshow("Original | Processed", combined);
+}
+
+// Update preprocess_static to accept avenue_name
+std::string preprocess_static(const Mat& frame, const std::string& avenue_name) {
+    Mat result = preprocess_frame(frame);
 
     long timestamp = chrono::system_clock::to_time_t(chrono::system_clock::now());
     string output_dir = "./resources/images/";
@@ -71,9 +86,7 @@ std::string test_static_image(const std::string& image_path, const std::string&
 
     // Side-by-side display
     Mat processed = imread(processed_path);
-    Mat combined;
-    hconcat(frame, processed, combined);
-    imshow("Original | Processed", combined);
+    show_preprocessing(frame, processed);
 
     return processed_path;
 }
\ No newline at end of file
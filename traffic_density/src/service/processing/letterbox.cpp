@@ -0,0 +1,186 @@
+#include <opencv2/opencv.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "letterbox.hpp"
+
+using namespace cv;
+using namespace std;
+
+// Same gray as darknet's letterbox padding (127.5 / 255).
+static const float kPadValue = 0.5f;
+
+// Source coordinate sampled by output pixel `d`, with cv::resize INTER_LINEAR
+// (pixel-center aligned) conventions and replicated borders.
+static void linearTap(int d, double inverseScale, int sourceSize, int& first, int& second, float& weight) {
+    double s = (d + 0.5) * inverseScale - 0.5;
+    int i = static_cast<int>(floor(s));
+    weight = static_cast<float>(s - i);
+    if (i < 0) {
+        i = 0;
+        weight = 0.0f;
+    }
+    if (i >= sourceSize - 1) {
+        i = sourceSize - 1;
+        weight = 0.0f;
+    }
+    first = i;
+    second = min(i + 1, sourceSize - 1);
+}
+
+// Horizontally resamples one BGR source row into interleaved floats (0..255).
+// The row is widened to float once (cv's own SIMD convert), then every output
+// element gathers its two taps through per-element indexes, so channels need
+// no special casing and the blend vectorizes across the interleaved row.
+static void resampleRow(const uchar* src, int sourceElements, const vector<int>& i0,
+                        const vector<int>& i1, const vector<float>& alpha, float* out) {
+    thread_local Mat widened;
+    Mat(1, sourceElements, CV_8U, const_cast<uchar*>(src)).convertTo(widened, CV_32F);
+    const float* row = widened.ptr<float>();
+
+    const int elements = static_cast<int>(i0.size());
+    int k = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+    const int lanes = VTraits<v_float32>::vlanes();
+    for (; k <= elements - lanes; k += lanes) {
+        v_float32 a = v_lut(row, i0.data() + k);
+        v_float32 b = v_lut(row, i1.data() + k);
+        v_store(out + k, v_fma(v_sub(b, a), vx_load(alpha.data() + k), a));
+    }
+#endif
+    for (; k < elements; ++k) {
+        float a = row[i0[k]];
+        out[k] = a + alpha[k] * (row[i1[k]] - a);
+    }
+}
+
+Letterbox letterboxBlob(const Mat& bgr, int size, Mat& blob) {
+    CV_Assert(bgr.type() == CV_8UC3 && !bgr.empty() && size > 0);
+
+    Letterbox box;
+    box.size = size;
+    box.scale = min(size / static_cast<float>(bgr.cols), size / static_cast<float>(bgr.rows));
+    const int newW = clamp(static_cast<int>(lround(bgr.cols * box.scale)), 1, size);
+    const int newH = clamp(static_cast<int>(lround(bgr.rows * box.scale)), 1, size);
+    box.padX = (size - newW) / 2;
+    box.padY = (size - newH) / 2;
+
+    const int dims[] = {1, 3, size, size};
+    blob.create(4, dims, CV_32F);
+    const size_t plane = static_cast<size_t>(size) * size;
+    float* base = blob.ptr<float>();
+    float* planes[3] = {base, base + plane, base + 2 * plane};  // R, G, B
+
+    // Column taps are shared by every row, expanded per interleaved element
+    // (3 * x + c) so the horizontal pass is one flat gather-and-blend.
+    const double invX = static_cast<double>(bgr.cols) / newW;
+    const double invY = static_cast<double>(bgr.rows) / newH;
+    thread_local vector<int> i0, i1;
+    thread_local vector<float> alpha;
+    i0.resize(static_cast<size_t>(newW) * 3);
+    i1.resize(static_cast<size_t>(newW) * 3);
+    alpha.resize(static_cast<size_t>(newW) * 3);
+    for (int x = 0; x < newW; ++x) {
+        int first, second;
+        float weight;
+        linearTap(x, invX, bgr.cols, first, second, weight);
+        for (int c = 0; c < 3; ++c) {
+            i0[3 * x + c] = first * 3 + c;
+            i1[3 * x + c] = second * 3 + c;
+            alpha[3 * x + c] = weight;
+        }
+    }
+    const int sourceElements = bgr.cols * 3;
+
+    // Two horizontally resampled source rows; consecutive output rows usually
+    // reuse one or both of them.
+    thread_local vector<float> rowBuffers[2];
+    rowBuffers[0].resize(static_cast<size_t>(newW) * 3);
+    rowBuffers[1].resize(static_cast<size_t>(newW) * 3);
+    float* top = rowBuffers[0].data();
+    float* bottom = rowBuffers[1].data();
+    int topY = -1, bottomY = -1;
+
+    const float normalize = 1.0f / 255.0f;
+
+    for (int y = 0; y < size; ++y) {
+        float* r = planes[0] + static_cast<size_t>(y) * size;
+        float* g = planes[1] + static_cast<size_t>(y) * size;
+        float* b = planes[2] + static_cast<size_t>(y) * size;
+
+        const int dy = y - box.padY;
+        if (dy < 0 || dy >= newH) {
+            fill(r, r + size, kPadValue);
+            fill(g, g + size, kPadValue);
+            fill(b, b + size, kPadValue);
+            continue;
+        }
+
+        int sy0, sy1;
+        float wy;
+        linearTap(dy, invY, bgr.rows, sy0, sy1, wy);
+        if (sy0 != topY) {
+            if (sy0 == bottomY) {
+                swap(top, bottom);
+                swap(topY, bottomY);
+            } else {
+                resampleRow(bgr.ptr<uchar>(sy0), sourceElements, i0, i1, alpha, top);
+                topY = sy0;
+            }
+        }
+        if (sy1 != bottomY) {
+            resampleRow(bgr.ptr<uchar>(sy1), sourceElements, i0, i1, alpha, bottom);
+            bottomY = sy1;
+        }
+
+        fill(r, r + box.padX, kPadValue);
+        fill(g, g + box.padX, kPadValue);
+        fill(b, b + box.padX, kPadValue);
+        fill(r + box.padX + newW, r + size, kPadValue);
+        fill(g + box.padX + newW, g + size, kPadValue);
+        fill(b + box.padX + newW, b + size, kPadValue);
+
+        r += box.padX;
+        g += box.padX;
+        b += box.padX;
+
+        // Vertical blend, 1/255 scaling, BGR -> RGB and deinterleave in one go.
+        int x = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+        const int lanes = VTraits<v_float32>::vlanes();
+        const v_float32 vwy = vx_setall_f32(wy);
+        const v_float32 vnorm = vx_setall_f32(normalize);
+        for (; x <= newW - lanes; x += lanes) {
+            v_float32 t0, t1, t2, b0, b1, b2;
+            v_load_deinterleave(top + 3 * x, t0, t1, t2);
+            v_load_deinterleave(bottom + 3 * x, b0, b1, b2);
+            v_store(b + x, v_mul(v_fma(v_sub(b0, t0), vwy, t0), vnorm));
+            v_store(g + x, v_mul(v_fma(v_sub(b1, t1), vwy, t1), vnorm));
+            v_store(r + x, v_mul(v_fma(v_sub(b2, t2), vwy, t2), vnorm));
+        }
+#endif
+        for (; x < newW; ++x) {
+            const float* t = top + 3 * x;
+            const float* u = bottom + 3 * x;
+            b[x] = (t[0] + wy * (u[0] - t[0])) * normalize;
+            g[x] = (t[1] + wy * (u[1] - t[1])) * normalize;
+            r[x] = (t[2] + wy * (u[2] - t[2])) * normalize;
+        }
+    }
+    return box;
+}
+
+Rect unletterboxBox(const Letterbox& box, const float* yolo, Size frameSize) {
+    float centerX = (yolo[0] * box.size - box.padX) / box.scale;
+    float centerY = (yolo[1] * box.size - box.padY) / box.scale;
+    float w = yolo[2] * box.size / box.scale;
+    float h = yolo[3] * box.size / box.scale;
+
+    Rect rect(static_cast<int>(centerX - w / 2), static_cast<int>(centerY - h / 2),
+              static_cast<int>(w), static_cast<int>(h));
+    return rect & Rect(0, 0, frameSize.width, frameSize.height);
+}
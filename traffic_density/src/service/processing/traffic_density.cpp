@@ -11,6 +11,10 @@
 #include <filesystem>
 #include <nlohmann/json.hpp>  // JSON library (https://github.com/nlohmann/json)
 
+#include "env_config.hpp"
+#include "letterbox.hpp"
+#include "traffic_analysis.hpp"
+
 using namespace cv;
 using namespace dnn;
 using namespace std;
@@ -42,7 +46,7 @@ private:
 };
 
 // === Rounded Box ===
-void drawRoundedRectangle(Mat& img, Rect box, Scalar color, int thickness = 2) {
+void drawRoundedRectangle(Mat& img, Rect box, Scalar color, int thickness) {
     int radius = static_cast<int>(min(box.width, box.height) * 0.1);
     Point tl = box.tl();
     Point br = box.br();
@@ -75,11 +79,21 @@ string getTimestamp() {
 }
 
 // =================================================================
-// === Main Analysis Function ===
+// === YOLO Model (one instance per thread) ===
 // =================================================================
-string analyzeTrafficDensity(const string& imagePath, const std::string& avenueName){
+// cv::dnn::Net is not thread-safe, so every thread that runs detection keeps
+// its own network. Loading happens on first use instead of on every frame.
+struct YoloModel {
+    Net net;
+    vector<String> outputLayers;
+    string error;   // empty when the model is ready
+};
 
-    printf("Starting traffic density analysis...\n");
+static YoloModel& getYoloModel() {
+    thread_local YoloModel model;
+    thread_local bool initialized = false;
+    if (initialized) return model;
+    initialized = true;
 
     // Use consistent paths for model files
     string weightsPath = "../resources/models/yolov3.weights";
@@ -94,60 +108,87 @@ string analyzeTrafficDensity(const string& imagePath, const std::string& avenueN
     if (!std::filesystem::exists(weightsPath) || !std::filesystem::exists(configPath)) {
         std::cerr << "YOLO model files not found!" << std::endl;
         std::cerr << "Looking for: " << weightsPath << " and " << configPath << std::endl;
-        return "Error: YOLO model files not found";
+        model.error = "Error: YOLO model files not found";
+        return model;
     }
 
     // Load YOLO model using Darknet-specific function
     printf("Loading YOLO model from: %s and %s\n", weightsPath.c_str(), configPath.c_str());
-    Net net;
     try {
-        net = readNetFromDarknet(configPath, weightsPath);
-        if (net.empty()) {
+        model.net = readNetFromDarknet(configPath, weightsPath);
+        if (model.net.empty()) {
             std::cerr << "Failed to load YOLO network (net is empty)" << std::endl;
-            return "Error: Failed to load YOLO network";
+            model.error = "Error: Failed to load YOLO network";
+            return model;
         }
     } catch (const cv::Exception& e) {
         std::cerr << "OpenCV exception while loading model: " << e.what() << std::endl;
-        return "Error: OpenCV exception during model loading";
+        model.error = "Error: OpenCV exception during model loading";
+        return model;
     } catch (const std::exception& e) {
         std::cerr << "Exception while loading model: " << e.what() << std::endl;
-        return "Error: Exception during model loading";
+        model.error = "Error: Exception during model loading";
+        return model;
     }
 
     printf("Model loaded successfully.\n");
 
     // Get output layer names
-    vector<String> layerNames = net.getLayerNames();
-    vector<int> outLayers = net.getUnconnectedOutLayers();
-    vector<String> outputLayers;
-    outputLayers.reserve(outLayers.size());
+    vector<String> layerNames = model.net.getLayerNames();
+    vector<int> outLayers = model.net.getUnconnectedOutLayers();
+    model.outputLayers.reserve(outLayers.size());
     for (int idx : outLayers) {
-        outputLayers.push_back(layerNames[idx - 1]);
+        model.outputLayers.push_back(layerNames[idx - 1]);
     }
+    return model;
+}
 
-    // Vehicle class IDs from COCO dataset
-    static const set<int> vehicleIds = {2, 3, 5, 7}; // car, motorbike, bus, truck
+// =================================================================
+// === Frame Analysis ===
+// =================================================================
+TrafficAnalysis analyzeTrafficFrame(const Mat& image) {
+    TrafficAnalysis result;
 
-    // Load image
-    Mat image = imread(imagePath);
+    YoloModel& model = getYoloModel();
+    if (!model.error.empty()) {
+        result.report = model.error;
+        return result;
+    }
     if (image.empty()) {
-        cerr << "Image not found!" << endl;
-        return "Error: Image not found";
+        result.report = "Error: Image not found";
+        return result;
     }
 
-    printf("Image loaded successfully.\n");
+    // Vehicle class IDs from COCO dataset
+    static const set<int> vehicleIds = {2, 3, 5, 7}; // car, motorbike, bus, truck
 
     int height = image.rows;
     int width = image.cols;
 
-    // Prepare input
-    Mat blob;
-    blobFromImage(image, blob, 0.00392, Size(416, 416),
-                  Scalar(0, 0, 0), true, false);
-    net.setInput(blob);
+    using clock = chrono::steady_clock;
+    auto stageStart = clock::now();
+
+    // Prepare input. The fused letterbox kernel keeps the aspect ratio and
+    // writes straight into a per-thread blob; LETTERBOX=0 restores the old
+    // stretched blobFromImage input (e.g. to compare against old goldens).
+    static const bool useLetterbox = envInt("LETTERBOX", 1) != 0;
+    const bool letterboxed = useLetterbox && image.type() == CV_8UC3;
+    thread_local Mat blob;
+    Letterbox letterbox;
+    if (letterboxed) {
+        letterbox = letterboxBlob(image, 416, blob);
+    } else {
+        blobFromImage(image, blob, 0.00392, Size(416, 416),
+                      Scalar(0, 0, 0), true, false);
+    }
+    model.net.setInput(blob);
+    result.timings.blobMs = chrono::duration<double, milli>(clock::now() - stageStart).count();
+    stageStart = clock::now();
 
     vector<Mat> outs;
-    net.forward(outs, outputLayers);
+    model.net.forward(outs, model.outputLayers);
+    result.timings.inferenceMs = chrono::duration<double, milli>(clock::now() - stageStart).count();
+    stageStart = clock::now();
 
     vector<int> classIds;
     vector<float> confidences;
@@ -163,14 +204,18 @@ string analyzeTrafficDensity(const string& imagePath, const std::string& avenueN
             int classId = classIdPoint.x;
 
             if (confidence > 0.5 && vehicleIds.count(classId)) {
-                int centerX = (int)(data[0] * width);
-                int centerY = (int)(data[1] * height);
-                int w = (int)(data[2] * width);
-                int h = (int)(data[3] * height);
-                int x = centerX - w / 2;
-                int y = centerY - h / 2;
-
-                boxes.push_back(Rect(x, y, w, h));
+                if (letterboxed) {
+                    boxes.push_back(unletterboxBox(letterbox, data, image.size()));
+                } else {
+                    int centerX = (int)(data[0] * width);
+                    int centerY = (int)(data[1] * height);
+                    int w = (int)(data[2] * width);
+                    int h = (int)(data[3] * height);
+                    int x = centerX - w / 2;
+                    int y = centerY - h / 2;
+
+                    boxes.push_back(Rect(x, y, w, h));
+                }
                 confidences.push_back((float)confidence);
                 classIds.push_back(classId);
             }
@@ -180,29 +225,39 @@ string analyzeTrafficDensity(const string& imagePath, const std::string& avenueN
     vector<int> indexes;
     NMSBoxes(boxes, confidences, 0.5, 0.4, indexes);
 
-    int vehicleCount = indexes.size();
-
     TrafficDensity densityAnalyzer(0.02);
-    vector<Rect> finalBoxes;
-    for (int idx : indexes) finalBoxes.push_back(boxes[idx]);
-    double density = densityAnalyzer.computeDensity(finalBoxes, image);
-    string condition = densityAnalyzer.analyzeDensity(density);
-
-    std::string report = std::to_string(vehicleCount) + 
-    " vehicles detected with density " + 
-    std::to_string(density) + 
-    ". Condition: " + 
-    condition;
+    for (int idx : indexes) result.boxes.push_back(boxes[idx]);
+
+    result.ok = true;
+    result.vehicleCount = static_cast<int>(indexes.size());
+    result.density = densityAnalyzer.computeDensity(result.boxes, image);
+    result.condition = densityAnalyzer.analyzeDensity(result.density);
+    result.timings.decodeMs = chrono::duration<double, milli>(clock::now() - stageStart).count();
+    result.report = std::to_string(result.vehicleCount) +
+    " vehicles detected with density " +
+    std::to_string(result.density) +
+    ". Condition: " +
+    result.condition;
+    return result;
+}
 
+// =================================================================
+// === Display ===
+// =================================================================
+void drawTrafficAnalysis(Mat& image, const TrafficAnalysis& analysis) {
     // Draw boxes
-    for (int idx : indexes) {
-        Rect box = boxes[idx];
+    for (const Rect& box : analysis.boxes) {
         drawRoundedRectangle(image, box, Scalar(0, 255, 0), 2);
         putText(image, "Vehicle",
                 Point(box.x, box.y - 8),
                 FONT_HERSHEY_SIMPLEX, 0.6,
                 Scalar(0, 255, 0), 2);
     }
+}
+
+void showTrafficAnalysis(const Mat& frame, const TrafficAnalysis& analysis) {
+    Mat image = frame.clone();
+    drawTrafficAnalysis(image, analysis);
 
     static bool windowInitialized = false;
     if (!windowInitialized) {
@@ -213,7 +268,31 @@ string analyzeTrafficDensity(const string& imagePath, const std::string& avenueN
 
     imshow("YOLO Vehicle Detection + Density", image);
     waitKey(1);   // non-blocking; window stays open
+}
+
+// =================================================================
+// === Main Analysis Function ===
+// =================================================================
+string analyzeTrafficDensity(const string& imagePath, const std::string& avenueName){
+
+    printf("Starting traffic density analysis...\n");
+
+    // Load image
+    Mat image = imread(imagePath);
+    if (image.empty()) {
+        cerr << "Image not found!" << endl;
+        return "Error: Image not found";
+    }
+
+    printf("Image loaded successfully.\n");
+
+    TrafficAnalysis analysis = analyzeTrafficFrame(image);
+    if (!analysis.ok) {
+        return analysis.report;
+    }
+
+    showTrafficAnalysis(image, analysis);
 
-    return report;
+    return analysis.report;
 
 }
@@ -0,0 +1,228 @@
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "env_config.hpp"
+#include "thread_budget.hpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static const char* kRoleNames[3] = {"capture", "preprocess", "inference"};
+
+static double threadCpuSeconds() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double processCpuSeconds() {
+    timespec ts{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Parses a kernel cpulist such as "0-3,8-11".
+static vector<int> parseCpuList(const string& text) {
+    vector<int> cores;
+    stringstream ranges(text);
+    string range;
+    while (getline(ranges, range, ',')) {
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        try {
+            int first = stoi(range.substr(0, dash));
+            int last = dash == string::npos ? first : stoi(range.substr(dash + 1));
+            for (int core = first; core <= last; ++core) cores.push_back(core);
+        } catch (const exception&) {
+            // ignore malformed ranges
+        }
+    }
+    return cores;
+}
+
+// Cores this process may use, ordered NUMA node by node.
+static vector<int> allowedCoresByNode() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    vector<int> allowed;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int core = 0; core < CPU_SETSIZE; ++core) {
+            if (CPU_ISSET(core, &set)) allowed.push_back(core);
+        }
+    }
+    if (allowed.empty()) allowed.push_back(0);
+
+    map<int, vector<int>> nodes;
+    error_code ec;
+    for (const auto& entry : fs::directory_iterator("/sys/devices/system/node", ec)) {
+        string name = entry.path().filename().string();
+        if (name.rfind("node", 0) != 0) continue;
+        int node = atoi(name.c_str() + 4);
+        ifstream file(entry.path() / "cpulist");
+        string list;
+        getline(file, list);
+        nodes[node] = parseCpuList(list);
+    }
+
+    vector<int> ordered;
+    for (const auto& [node, cores] : nodes) {
+        for (int core : cores) {
+            if (find(allowed.begin(), allowed.end(), core) != allowed.end() &&
+                find(ordered.begin(), ordered.end(), core) == ordered.end()) {
+                ordered.push_back(core);
+            }
+        }
+    }
+    // Cores without NUMA information (or no sysfs at all) go last.
+    for (int core : allowed) {
+        if (find(ordered.begin(), ordered.end(), core) == ordered.end()) ordered.push_back(core);
+    }
+    return ordered;
+}
+
+ThreadBudgetConfig ThreadBudgetConfig::fromEnv() {
+    ThreadBudgetConfig config;
+    config.enabled = envInt("THREAD_BUDGET", config.enabled ? 1 : 0) != 0;
+    config.captureCores = max(0, static_cast<int>(envInt("THREAD_BUDGET_CAPTURE_CORES", config.captureCores)));
+    config.preprocessCores = max(0, static_cast<int>(envInt("THREAD_BUDGET_PREPROCESS_CORES", config.preprocessCores)));
+    config.inferenceCores = max(0, static_cast<int>(envInt("THREAD_BUDGET_INFERENCE_CORES", config.inferenceCores)));
+    config.pin = envInt("THREAD_BUDGET_PIN", config.pin ? 1 : 0) != 0;
+    return config;
+}
+
+ThreadBudget& ThreadBudget::instance() {
+    static ThreadBudget budget;
+    return budget;
+}
+
+void ThreadBudget::configure(const ThreadBudgetConfig& config) {
+    lock_guard<mutex> lock(mutex_);
+    lastReport_ = chrono::steady_clock::now();
+    lastProcessCpu_ = processCpuSeconds();
+    if (!config.enabled) return;
+
+    allowedCores_ = allowedCoresByNode();
+    int total = static_cast<int>(allowedCores_.size());
+
+    // Automatic split: capture is mostly I/O and decode, inference gets the rest.
+    int capture = config.captureCores > 0 ? config.captureCores : max(1, total / 8);
+    int preprocess = config.preprocessCores > 0 ? config.preprocessCores : max(1, total / 4);
+    int inference = config.inferenceCores > 0 ? config.inferenceCores : max(1, total - capture - preprocess);
+
+    // Hand out consecutive cores, inference first so it stays on the first
+    // node. If the roles ask for more cores than exist they wrap and share.
+    int next = 0;
+    auto take = [&](int count) {
+        vector<int> cores;
+        for (int i = 0; i < min(count, total); ++i) cores.push_back(allowedCores_[(next + i) % total]);
+        next = (next + count) % total;
+        return cores;
+    };
+    roleCores_[static_cast<int>(WorkerRole::Inference)] = take(inference);
+    roleCores_[static_cast<int>(WorkerRole::Preprocess)] = take(preprocess);
+    roleCores_[static_cast<int>(WorkerRole::Capture)] = take(capture);
+
+    // OpenCV has one pool for the whole process, shared by every stage and
+    // every concurrent caller (CLAHE and bilateralFilter use it as much as the
+    // DNN does), so it cannot be split per role or per worker. It is sized to
+    // the inference share, which keeps the pool plus the pinned stage threads
+    // within the machine.
+    poolThreads_ = min(inference, total);
+    cv::setNumThreads(poolThreads_);
+
+    configured_ = true;
+    pinning_ = config.pin;
+
+    // The pool is created lazily and its threads inherit the creator's
+    // affinity. Create it here, from the unpinned main thread, so it spans
+    // every allowed core instead of the cores of whichever stage calls first.
+    cv::parallel_for_(cv::Range(0, poolThreads_ * 4), [](const cv::Range&) {});
+
+    ostringstream out;
+    out << "[BUDGET] " << total << " cores:";
+    for (int role = 0; role < 3; ++role) {
+        out << " " << kRoleNames[role] << "=[";
+        for (size_t i = 0; i < roleCores_[role].size(); ++i) out << (i ? "," : "") << roleCores_[role][i];
+        out << "]";
+    }
+    out << (pinning_ ? " (stage threads pinned)" : " (not pinned)")
+        << " opencv_pool=" << poolThreads_ << " threads, shared, unpinned\n";
+    cout << out.str();
+}
+
+bool ThreadBudget::pin(WorkerRole role) {
+    lock_guard<mutex> lock(mutex_);
+    if (!configured_ || !pinning_) return false;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int core : roleCores_[static_cast<int>(role)]) CPU_SET(core, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+void ThreadBudget::unpin() {
+    lock_guard<mutex> lock(mutex_);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int core : allowedCores_) CPU_SET(core, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+void ThreadBudget::charge(WorkerRole role, double cpuSeconds) {
+    lock_guard<mutex> lock(mutex_);
+    roleCpuSeconds_[static_cast<int>(role)] += cpuSeconds;
+}
+
+string ThreadBudget::report() {
+    lock_guard<mutex> lock(mutex_);
+    auto now = chrono::steady_clock::now();
+    double elapsed = chrono::duration<double>(now - lastReport_).count();
+    double processCpu = processCpuSeconds();
+    if (elapsed <= 0.0) return "";
+
+    ostringstream out;
+    out << fixed << setprecision(1) << "[BUDGET] stage threads:";
+    double charged = 0.0;
+    for (int role = 0; role < 3; ++role) {
+        // CPU of the threads inside a Scope, relative to the role's own cores.
+        // Work they hand to OpenCV's pool runs on pool threads and is not here,
+        // whichever role it came from.
+        double cores = max<size_t>(1, roleCores_[role].size());
+        out << " " << kRoleNames[role] << "=" << 100.0 * roleCpuSeconds_[role] / (elapsed * cores) << "%";
+        charged += roleCpuSeconds_[role];
+        roleCpuSeconds_[role] = 0.0;
+    }
+    // Everything not charged to a stage: OpenCV's pool plus unscoped threads
+    // (HTTP, fetcher loop, scheduler), none of them pinned. Scopes are charged
+    // when they end, so a long one can push this slightly below zero.
+    double allCores = max<size_t>(1, allowedCores_.empty() ? 1 : allowedCores_.size());
+    double processDelta = processCpu - lastProcessCpu_;
+    out << " | opencv_pool+other=" << 100.0 * max(0.0, processDelta - charged) / (elapsed * allCores) << "%"
+        << " process=" << 100.0 * processDelta / (elapsed * allCores) << "% of "
+        << static_cast<int>(allCores) << " cores\n";
+
+    lastReport_ = now;
+    lastProcessCpu_ = processCpu;
+    return out.str();
+}
+
+ThreadBudget::Scope::Scope(WorkerRole role) : role_(role), cpuStart_(threadCpuSeconds()) {
+    pinned_ = ThreadBudget::instance().pin(role);
+}
+
+ThreadBudget::Scope::~Scope() {
+    ThreadBudget& budget = ThreadBudget::instance();
+    budget.charge(role_, threadCpuSeconds() - cpuStart_);
+    if (pinned_) budget.unpin();
+}
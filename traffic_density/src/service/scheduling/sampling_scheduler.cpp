@@ -0,0 +1,271 @@
+#include "sampling_scheduler.hpp"
+#include "env_config.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+// CPU time consumed by the whole process (all threads, including OpenCV's).
+static double processCpuSeconds() {
+    timespec ts{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+SchedulerConfig SchedulerConfig::fromEnv() {
+    SchedulerConfig config;
+    config.minInterval = chrono::milliseconds(envInt("SCHEDULER_MIN_INTERVAL_MS", config.minInterval.count()));
+    config.maxInterval = chrono::milliseconds(envInt("SCHEDULER_MAX_INTERVAL_MS", config.maxInterval.count()));
+    config.volatilityReference = envDouble("SCHEDULER_VOLATILITY_REF", config.volatilityReference);
+    config.nightStartHour = static_cast<int>(envInt("SCHEDULER_NIGHT_START_HOUR", config.nightStartHour));
+    config.nightEndHour = static_cast<int>(envInt("SCHEDULER_NIGHT_END_HOUR", config.nightEndHour));
+    config.nightIntervalFactor = envDouble("SCHEDULER_NIGHT_FACTOR", config.nightIntervalFactor);
+    config.workers = static_cast<int>(envInt("SCHEDULER_WORKERS", config.workers));
+    config.cpuBudget = envDouble("SCHEDULER_CPU_BUDGET", config.cpuBudget);
+
+    config.workers = max(1, config.workers);
+    config.minInterval = max(config.minInterval, chrono::milliseconds(1));
+    config.maxInterval = max(config.maxInterval, config.minInterval);
+    config.cpuBudget = clamp(config.cpuBudget, 0.05, 1.0);
+    if (config.volatilityReference <= 0.0) config.volatilityReference = 0.01;
+    return config;
+}
+
+SamplingScheduler::SamplingScheduler(SchedulerConfig config) : config_(config) {
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    cpuRate_ = config_.cpuBudget * cores;
+}
+
+SamplingScheduler::~SamplingScheduler() {
+    stop();
+}
+
+void SamplingScheduler::addCamera(const string& name, SampleJob job, IntervalListener onInterval) {
+    lock_guard<mutex> lock(mutex_);
+    if (running_) {
+        cerr << "[SCHED] Cannot add camera " << name << " while running\n";
+        return;
+    }
+    Camera camera;
+    camera.name = name;
+    camera.job = move(job);
+    camera.onInterval = move(onInterval);
+    camera.stats.name = name;
+    camera.stats.interval = config_.maxInterval;
+    cameras_.push_back(move(camera));
+}
+
+void SamplingScheduler::start() {
+    lock_guard<mutex> lock(mutex_);
+    if (running_) return;
+    running_ = true;
+
+    // Stagger the first release a little so cameras don't all fire at once.
+    auto now = clock::now();
+    for (size_t i = 0; i < cameras_.size(); ++i) {
+        auto release = now + chrono::milliseconds(50 * i);
+        pending_.push({release, release + config_.maxInterval, i});
+        if (cameras_[i].onInterval) cameras_[i].onInterval(cameras_[i].stats.interval);
+    }
+
+    lastRefill_ = now;
+    lastCpuSeconds_ = processCpuSeconds();
+    cpuTokens_ = cpuRate_;  // one second worth of budget to start with
+    idleWorkers_ = config_.workers;
+
+    ostringstream banner;
+    banner << "[SCHED] Starting " << config_.workers << " workers for "
+           << cameras_.size() << " cameras (CPU budget "
+           << fixed << setprecision(2) << cpuRate_ << " cores)\n";
+    cout << banner.str();
+
+    for (int i = 0; i < config_.workers; ++i) {
+        workers_.emplace_back(&SamplingScheduler::workerLoop, this);
+    }
+    dispatcher_ = thread(&SamplingScheduler::dispatchLoop, this);
+}
+
+void SamplingScheduler::stop() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!running_) return;
+        running_ = false;
+    }
+    dispatchCv_.notify_all();
+    workCv_.notify_all();
+    if (dispatcher_.joinable()) dispatcher_.join();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+    workers_.clear();
+
+    // Drop whatever was still queued so a restart begins from a clean slate.
+    pending_ = {};
+    released_ = {};
+    ready_.clear();
+}
+
+void SamplingScheduler::refillBudget(clock::time_point now) {
+    double elapsed = chrono::duration<double>(now - lastRefill_).count();
+    double cpuNow = processCpuSeconds();
+    cpuTokens_ += elapsed * cpuRate_ - (cpuNow - lastCpuSeconds_);
+    cpuTokens_ = min(cpuTokens_, cpuRate_);  // bucket holds at most one second of budget
+    lastRefill_ = now;
+    lastCpuSeconds_ = cpuNow;
+}
+
+void SamplingScheduler::dispatchLoop() {
+    unique_lock<mutex> lock(mutex_);
+    while (running_) {
+        auto now = clock::now();
+        refillBudget(now);
+
+        while (!pending_.empty() && pending_.top().release <= now) {
+            released_.push(pending_.top());
+            pending_.pop();
+        }
+
+        if (released_.empty()) {
+            if (pending_.empty()) dispatchCv_.wait(lock);
+            else dispatchCv_.wait_until(lock, pending_.top().release);
+            continue;
+        }
+        if (idleWorkers_ == 0) {
+            dispatchCv_.wait(lock);
+            continue;
+        }
+        if (cpuTokens_ < 0.0) {
+            // Over budget: wait until enough CPU time has been refilled.
+            auto deficit = chrono::duration<double>(-cpuTokens_ / cpuRate_);
+            dispatchCv_.wait_for(lock, chrono::duration_cast<chrono::milliseconds>(deficit) + chrono::milliseconds(1));
+            continue;
+        }
+
+        ready_.push_back(released_.top());
+        released_.pop();
+        --idleWorkers_;
+        workCv_.notify_one();
+    }
+}
+
+void SamplingScheduler::workerLoop() {
+    unique_lock<mutex> lock(mutex_);
+    while (true) {
+        workCv_.wait(lock, [this] { return !running_ || !ready_.empty(); });
+        if (!running_) return;
+
+        Release task = ready_.front();
+        ready_.pop_front();
+        SampleJob job = cameras_[task.camera].job;
+        lock.unlock();
+
+        auto started = clock::now();
+        double density = -1.0;
+        try {
+            density = job();
+        } catch (const exception& e) {
+            cerr << "[SCHED] Job for " << cameras_[task.camera].name << " threw: " << e.what() << "\n";
+        }
+
+        lock.lock();
+        complete(task, started, density);
+        ++idleWorkers_;
+        dispatchCv_.notify_one();
+    }
+}
+
+void SamplingScheduler::complete(const Release& task, clock::time_point started, double density) {
+    Camera& camera = cameras_[task.camera];
+    auto finished = clock::now();
+
+    if (density == kSampleSkipped) {
+        // Same frame as last time: try again one interval later, as is.
+        camera.stats.skipped++;
+        if (!running_) return;
+        auto release = max(started + camera.stats.interval, finished);
+        pending_.push({release, release + camera.stats.interval, task.camera});
+        return;
+    }
+
+    camera.stats.samples++;
+    camera.totalLatencyMs += chrono::duration<double, milli>(finished - started).count();
+    camera.stats.meanLatencyMs = camera.totalLatencyMs / camera.stats.samples;
+    if (finished > task.deadline) camera.stats.missedDeadlines++;
+
+    auto previousInterval = camera.stats.interval;
+    if (density < 0.0) {
+        // Dead or unreachable camera: back off to the slowest cadence.
+        camera.stats.failures++;
+        camera.stats.interval = config_.maxInterval;
+    } else {
+        if (camera.hasDensity) {
+            double change = fabs(density - camera.stats.lastDensity);
+            camera.stats.volatility = config_.volatilitySmoothing * change +
+                                      (1.0 - config_.volatilitySmoothing) * camera.stats.volatility;
+        }
+        camera.stats.lastDensity = density;
+        camera.hasDensity = true;
+        camera.stats.interval = computeInterval(camera);
+    }
+    if (camera.onInterval && camera.stats.interval != previousInterval) camera.onInterval(camera.stats.interval);
+
+    if (!running_) return;
+
+    auto release = max(started + camera.stats.interval, finished);
+    pending_.push({release, release + camera.stats.interval, task.camera});
+}
+
+chrono::milliseconds SamplingScheduler::computeInterval(const Camera& camera) const {
+    double activity = min(1.0, camera.stats.volatility / config_.volatilityReference);
+    double minMs = static_cast<double>(config_.minInterval.count());
+    double maxMs = static_cast<double>(config_.maxInterval.count());
+    double intervalMs = maxMs - (maxMs - minMs) * activity;
+
+    if (isNight()) {
+        intervalMs = min(intervalMs * config_.nightIntervalFactor, maxMs * config_.nightIntervalFactor);
+    }
+    return chrono::milliseconds(static_cast<long long>(max(minMs, intervalMs)));
+}
+
+bool SamplingScheduler::isNight() const {
+    time_t t = time(nullptr);
+    tm local_tm{};
+    localtime_r(&t, &local_tm);
+    int hour = local_tm.tm_hour;
+    if (config_.nightStartHour == config_.nightEndHour) return false;
+    if (config_.nightStartHour < config_.nightEndHour) {
+        return hour >= config_.nightStartHour && hour < config_.nightEndHour;
+    }
+    return hour >= config_.nightStartHour || hour < config_.nightEndHour;  // window wraps midnight
+}
+
+vector<CameraStats> SamplingScheduler::stats() const {
+    lock_guard<mutex> lock(mutex_);
+    vector<CameraStats> result;
+    result.reserve(cameras_.size());
+    for (const auto& camera : cameras_) result.push_back(camera.stats);
+    return result;
+}
+
+string SamplingScheduler::summary() const {
+    ostringstream out;
+    out << fixed << setprecision(3);
+    for (const auto& s : stats()) {
+        out << "[SCHED] " << s.name
+            << " interval=" << s.interval.count() << "ms"
+            << " density=" << s.lastDensity
+            << " volatility=" << s.volatility
+            << " samples=" << s.samples
+            << " failures=" << s.failures
+            << " skipped=" << s.skipped
+            << " missed=" << s.missedDeadlines
+            << " mean_latency=" << setprecision(1) << s.meanLatencyMs << "ms"
+            << setprecision(3) << "\n";
+    }
+    return out.str();
+}
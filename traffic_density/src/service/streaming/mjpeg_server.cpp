@@ -0,0 +1,350 @@
+#include "mjpeg_server.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char* kBoundary = "frame";
+
+MjpegServer::MjpegServer(int port, string bindAddress) : port_(port), bindAddress_(move(bindAddress)) {}
+
+MjpegServer::~MjpegServer() {
+    stop();
+}
+
+bool MjpegServer::start() {
+    if (running_) return true;
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port_));
+    if (inet_pton(AF_INET, bindAddress_.c_str(), &addr.sin_addr) != 1) {
+        cerr << "[HTTP] Invalid bind address '" << bindAddress_ << "' (expected an IPv4 address)\n";
+        return false;
+    }
+
+    listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd_ < 0) {
+        cerr << "[HTTP] socket() failed: " << strerror(errno) << "\n";
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listenFd_, 128) < 0) {
+        cerr << "[HTTP] Cannot listen on " << bindAddress_ << ":" << port_ << ": " << strerror(errno) << "\n";
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+
+    // Port 0 lets the kernel pick one; report what we actually got.
+    socklen_t len = sizeof(addr);
+    if (getsockname(listenFd_, reinterpret_cast<sockaddr*>(&addr), &len) == 0) {
+        port_ = ntohs(addr.sin_port);
+    }
+
+    running_ = true;
+    acceptThread_ = thread(&MjpegServer::acceptLoop, this);
+    cout << "[HTTP] Serving MJPEG on " << bindAddress_ << ":" << port_ << "\n";
+    return true;
+}
+
+void MjpegServer::stop() {
+    if (!running_.exchange(false)) return;
+
+    // shutdown() wakes accept(); the fd is only closed once the accept thread
+    // is gone, so it never sees a closed (or reused) descriptor number.
+    shutdown(listenFd_, SHUT_RDWR);
+    if (acceptThread_.joinable()) acceptThread_.join();
+    close(listenFd_);
+    listenFd_ = -1;
+
+    {
+        lock_guard<mutex> lock(streamsMutex_);
+        for (auto& [name, s] : streams_) {
+            lock_guard<mutex> streamLock(s->mutex);
+            s->cv.notify_all();
+        }
+    }
+
+    unique_lock<mutex> lock(clientsMutex_);
+    for (int fd : clientFds_) shutdown(fd, SHUT_RDWR);
+    clientsCv_.wait(lock, [this] { return activeClients_ == 0; });
+}
+
+shared_ptr<MjpegServer::Stream> MjpegServer::stream(const string& name, bool create) {
+    lock_guard<mutex> lock(streamsMutex_);
+    auto it = streams_.find(name);
+    if (it != streams_.end()) return it->second;
+    if (!create) return nullptr;
+    auto created = make_shared<Stream>();
+    streams_[name] = created;
+    return created;
+}
+
+void MjpegServer::publishJpeg(const string& name, JpegBuffer jpeg) {
+    auto s = stream(name, true);
+    lock_guard<mutex> lock(s->mutex);
+    s->jpeg = move(jpeg);
+    s->producer = nullptr;
+    s->sequence++;
+    s->cv.notify_all();
+}
+
+void MjpegServer::publishLazy(const string& name, JpegProducer producer) {
+    auto s = stream(name, true);
+    lock_guard<mutex> lock(s->mutex);
+    s->jpeg = nullptr;
+    s->producer = move(producer);
+    s->sequence++;
+    s->cv.notify_all();
+}
+
+// Returns the JPEG for the stream's current frame, running the lazy producer
+// if nobody has yet. Called with the stream lock held; the producer itself runs
+// unlocked so publishers never wait for an encode.
+JpegBuffer MjpegServer::currentJpeg(Stream& s, unique_lock<mutex>& lock) {
+    while (!s.jpeg && s.producer) {
+        if (s.encoding) {
+            s.cv.wait(lock);
+            continue;
+        }
+
+        JpegProducer producer = s.producer;
+        uint64_t sequence = s.sequence;
+        s.encoding = true;
+        lock.unlock();
+
+        JpegBuffer jpeg;
+        try {
+            jpeg = producer();
+        } catch (const exception& e) {
+            cerr << "[HTTP] Frame producer failed: " << e.what() << "\n";
+        }
+
+        lock.lock();
+        s.encoding = false;
+        if (s.sequence == sequence) {
+            s.jpeg = jpeg;
+            s.producer = nullptr;
+        }
+        s.cv.notify_all();
+        return jpeg;  // may be one frame old if a newer one arrived meanwhile
+    }
+    return s.jpeg;
+}
+
+void MjpegServer::disconnectClients(const string& name) {
+    auto s = stream(name, false);
+    if (!s) return;
+    lock_guard<mutex> lock(s->mutex);
+    s->generation++;
+    s->cv.notify_all();
+}
+
+void MjpegServer::clearFrame(const string& name) {
+    auto s = stream(name, false);
+    if (!s) return;
+    lock_guard<mutex> lock(s->mutex);
+    s->jpeg = nullptr;
+    s->producer = nullptr;
+    s->sequence++;  // an encode still running for the old frame is not kept
+}
+
+int MjpegServer::clientCount(const string& name) const {
+    lock_guard<mutex> lock(streamsMutex_);
+    auto it = streams_.find(name);
+    return it == streams_.end() ? 0 : it->second->clients.load();
+}
+
+void MjpegServer::acceptLoop() {
+    while (running_) {
+        int fd = accept(listenFd_, nullptr, nullptr);
+        if (fd < 0) {
+            if (!running_) break;
+            if (errno != EINTR) this_thread::sleep_for(chrono::milliseconds(10));
+            continue;
+        }
+
+        // Never let a stalled client block a connection thread forever.
+        timeval timeout{5, 0};
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        timeval idle{30, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &idle, sizeof(idle));
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        {
+            lock_guard<mutex> lock(clientsMutex_);
+            clientFds_.insert(fd);
+            activeClients_++;
+        }
+
+        thread([this, fd] {
+            serveClient(fd);
+            close(fd);
+            lock_guard<mutex> lock(clientsMutex_);
+            clientFds_.erase(fd);
+            activeClients_--;
+            clientsCv_.notify_all();
+        }).detach();
+    }
+}
+
+void MjpegServer::serveClient(int fd) {
+    string buffer;
+    bool keepAlive = true;
+
+    while (running_ && keepAlive) {
+        size_t end;
+        while ((end = buffer.find("\r\n\r\n")) == string::npos) {
+            char chunk[2048];
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0 || buffer.size() > 16384) return;
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+        string request = buffer.substr(0, end);
+        buffer.erase(0, end + 4);
+
+        string method, path, version;
+        istringstream(request) >> method >> path >> version;
+        path = path.substr(0, path.find('?'));
+
+        string lower = request;
+        transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        keepAlive = version == "HTTP/1.1" && lower.find("connection: close") == string::npos;
+
+        if (method != "GET") {
+            sendText(fd, 405, "Method Not Allowed", "Only GET is supported\n", false);
+            return;
+        }
+
+        if (path == "/") {
+            ostringstream body;
+            {
+                lock_guard<mutex> lock(streamsMutex_);
+                for (const auto& [name, s] : streams_) {
+                    body << "/stream/" << name << "  /snapshot/" << name
+                         << "  clients=" << s->clients.load() << "\n";
+                }
+            }
+            if (!sendText(fd, 200, "OK", body.str(), keepAlive)) return;
+            continue;
+        }
+
+        const string streamPrefix = "/stream/";
+        const string snapshotPrefix = "/snapshot/";
+        if (path.rfind(streamPrefix, 0) == 0) {
+            auto s = stream(path.substr(streamPrefix.size()), false);
+            if (!s) {
+                sendText(fd, 404, "Not Found", "Unknown stream\n", false);
+                return;
+            }
+            serveStream(fd, s);
+            return;  // a stream response owns the connection until it ends
+        }
+        if (path.rfind(snapshotPrefix, 0) == 0) {
+            auto s = stream(path.substr(snapshotPrefix.size()), false);
+            if (!s) {
+                if (!sendText(fd, 404, "Not Found", "Unknown stream\n", keepAlive)) return;
+                continue;
+            }
+            if (!serveSnapshot(fd, s, keepAlive)) return;
+            continue;
+        }
+
+        if (!sendText(fd, 404, "Not Found", "Not found\n", keepAlive)) return;
+    }
+}
+
+bool MjpegServer::serveStream(int fd, const shared_ptr<Stream>& s) {
+    string header = string("HTTP/1.1 200 OK\r\n") +
+                    "Content-Type: multipart/x-mixed-replace; boundary=" + kBoundary + "\r\n" +
+                    "Cache-Control: no-cache\r\n"
+                    "Connection: close\r\n\r\n";
+    if (!sendAll(fd, header.data(), header.size())) return false;
+
+    s->clients++;
+    uint64_t lastSequence = 0;
+    uint64_t generation;
+    {
+        lock_guard<mutex> lock(s->mutex);
+        generation = s->generation;
+    }
+
+    bool ok = true;
+    while (ok) {
+        JpegBuffer jpeg;
+        {
+            unique_lock<mutex> lock(s->mutex);
+            s->cv.wait_for(lock, chrono::seconds(1), [&] {
+                return !running_ || s->generation != generation ||
+                       ((s->jpeg || s->producer) && s->sequence != lastSequence);
+            });
+            if (!running_ || s->generation != generation) break;
+            if ((!s->jpeg && !s->producer) || s->sequence == lastSequence) continue;
+            lastSequence = s->sequence;
+            jpeg = currentJpeg(*s, lock);
+        }
+        if (!jpeg) continue;
+
+        string part = string("--") + kBoundary + "\r\n"
+                      "Content-Type: image/jpeg\r\n"
+                      "Content-Length: " + to_string(jpeg->size()) + "\r\n\r\n";
+        ok = sendAll(fd, part.data(), part.size()) &&
+             sendAll(fd, jpeg->data(), jpeg->size()) &&
+             sendAll(fd, "\r\n", 2);
+    }
+    s->clients--;
+    return ok;
+}
+
+bool MjpegServer::serveSnapshot(int fd, const shared_ptr<Stream>& s, bool keepAlive) {
+    JpegBuffer jpeg;
+    {
+        unique_lock<mutex> lock(s->mutex);
+        s->cv.wait_for(lock, chrono::seconds(2), [&] { return !running_ || s->jpeg || s->producer; });
+        jpeg = currentJpeg(*s, lock);
+    }
+    if (!jpeg) return sendText(fd, 503, "Service Unavailable", "No frame yet\n", keepAlive);
+
+    string header = string("HTTP/1.1 200 OK\r\n") +
+                    "Content-Type: image/jpeg\r\n"
+                    "Content-Length: " + to_string(jpeg->size()) + "\r\n"
+                    "Cache-Control: no-cache\r\n"
+                    "Connection: " + (keepAlive ? "keep-alive" : "close") + "\r\n\r\n";
+    return sendAll(fd, header.data(), header.size()) && sendAll(fd, jpeg->data(), jpeg->size());
+}
+
+bool MjpegServer::sendText(int fd, int status, const string& reason, const string& body, bool keepAlive) {
+    string response = "HTTP/1.1 " + to_string(status) + " " + reason + "\r\n" +
+                      "Content-Type: text/plain\r\n"
+                      "Content-Length: " + to_string(body.size()) + "\r\n"
+                      "Connection: " + (keepAlive ? "keep-alive" : "close") + "\r\n\r\n" + body;
+    return sendAll(fd, response.data(), response.size());
+}
+
+bool MjpegServer::sendAll(int fd, const void* data, size_t size) {
+    const char* ptr = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t sent = send(fd, ptr, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        ptr += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
@@ -0,0 +1,150 @@
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "env_config.hpp"
+#include "ingest.hpp"
+#include "load_driver.hpp"
+#include "pre_processing.hpp"
+#include "sampling_scheduler.hpp"
+#include "snapshot_fetcher.hpp"
+#include "thread_budget.hpp"
+#include "traffic_analysis.hpp"
+
+using namespace std;
+
+LoadDriverConfig LoadDriverConfig::fromEnv() {
+    LoadDriverConfig config;
+    config.cameras = max(1, static_cast<int>(envInt("LOAD_CAMERAS", config.cameras)));
+    config.baseUrl = envString("LOAD_BASE_URL", config.baseUrl);
+    config.durationSeconds = max(1, static_cast<int>(envInt("LOAD_DURATION_SECONDS", config.durationSeconds)));
+    config.preprocess = envInt("LOAD_PREPROCESS", config.preprocess ? 1 : 0) != 0;
+    config.snapshots = envInt("LOAD_SNAPSHOTS", config.snapshots ? 1 : 0) != 0;
+    return config;
+}
+
+static double percentile(vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    size_t index = min(values.size() - 1, static_cast<size_t>(p * (values.size() - 1) + 0.5));
+    nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+int runLoadDriver(const LoadDriverConfig& config) {
+    struct Samples {
+        std::mutex lock;
+        vector<double> captureMs;
+        vector<double> analysisMs;
+        vector<double> totalMs;
+        uint64_t failures = 0;
+    } samples;
+
+    using clock = chrono::steady_clock;
+    SchedulerConfig schedulerConfig = SchedulerConfig::fromEnv();
+    ThreadBudget::instance().configure(ThreadBudgetConfig::fromEnv());
+    SamplingScheduler scheduler(schedulerConfig);
+
+    vector<CameraSource> cameras;
+    for (int i = 0; i < config.cameras; ++i) {
+        string path = (config.snapshots ? "/snapshot/cam" : "/stream/cam") + to_string(i);
+        cameras.push_back({"cam" + to_string(i), config.baseUrl + path, config.snapshots});
+    }
+
+    // Snapshot mode: one event loop polls every camera, jobs take the newest frame.
+    unique_ptr<SnapshotFetcher> fetcher;
+    if (config.snapshots) {
+        FetcherConfig fetchConfig = FetcherConfig::fromEnv();
+        fetcher = make_unique<SnapshotFetcher>(fetchConfig, cameras);
+        if (!fetcher->start()) return 1;
+    }
+    SnapshotFetcher* snapshots = fetcher.get();
+
+    for (int i = 0; i < config.cameras; ++i) {
+        CameraSource camera = cameras[i];
+        bool preprocess = config.preprocess;
+
+        auto lastFrame = make_shared<uint64_t>(0);
+        scheduler.addCamera(camera.name, [camera, i, snapshots, preprocess, lastFrame, &samples]() -> double {
+            auto start = clock::now();
+            cv::Mat frame;
+            bool captured;
+            uint64_t sequence = 0;
+            {
+                ThreadBudget::Scope scope(WorkerRole::Capture);
+                captured = snapshots ? snapshots->latestFrame(i, frame, sequence) : capture_camera_frame(camera, frame);
+            }
+            if (captured && snapshots) {
+                if (sequence == *lastFrame) return kSampleSkipped;
+                *lastFrame = sequence;
+            }
+            auto captured_at = clock::now();
+
+            TrafficAnalysis analysis;
+            if (captured) {
+                if (preprocess) {
+                    ThreadBudget::Scope scope(WorkerRole::Preprocess);
+                    frame = preprocess_frame(frame);
+                }
+                ThreadBudget::Scope scope(WorkerRole::Inference);
+                analysis = analyzeTrafficFrame(frame);
+            }
+            auto done = clock::now();
+
+            lock_guard<mutex> guard(samples.lock);
+            if (!captured || !analysis.ok) {
+                samples.failures++;
+                return -1.0;
+            }
+            samples.captureMs.push_back(chrono::duration<double, milli>(captured_at - start).count());
+            samples.analysisMs.push_back(chrono::duration<double, milli>(done - captured_at).count());
+            samples.totalMs.push_back(chrono::duration<double, milli>(done - start).count());
+            return analysis.density;
+        }, [snapshots, i](chrono::milliseconds interval) {
+            if (snapshots) snapshots->setInterval(i, interval);
+        });
+    }
+
+    cout << "[LOAD] Driving " << config.cameras << " cameras at " << config.baseUrl
+         << " for " << config.durationSeconds << " s\n";
+
+    auto started = clock::now();
+    scheduler.start();
+    this_thread::sleep_for(chrono::seconds(config.durationSeconds));
+    scheduler.stop();
+    double elapsed = chrono::duration<double>(clock::now() - started).count();
+
+    cout << scheduler.summary() << ThreadBudget::instance().report();
+    if (fetcher) {
+        cout << fetcher->summary();
+        fetcher->stop();
+    }
+
+    lock_guard<mutex> guard(samples.lock);
+    ostringstream out;
+    out << fixed << setprecision(1);
+    out << "[LOAD] frames=" << samples.totalMs.size()
+        << " failures=" << samples.failures
+        << " throughput=" << setprecision(2) << samples.totalMs.size() / elapsed << " frames/s\n"
+        << setprecision(1);
+    auto line = [&out](const char* label, const vector<double>& values) {
+        out << "[LOAD] " << label
+            << " p50=" << percentile(values, 0.50) << "ms"
+            << " p95=" << percentile(values, 0.95) << "ms"
+            << " p99=" << percentile(values, 0.99) << "ms\n";
+    };
+    line("capture ", samples.captureMs);
+    line("analysis", samples.analysisMs);
+    line("total   ", samples.totalMs);
+    cout << out.str();
+
+    return samples.totalMs.empty() ? 1 : 0;
+}
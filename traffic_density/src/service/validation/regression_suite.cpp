@@ -0,0 +1,322 @@
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "env_config.hpp"
+#include "letterbox.hpp"
+#include "pre_processing.hpp"
+#include "regression_suite.hpp"
+#include "traffic_analysis.hpp"
+
+using namespace cv;
+using namespace std;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+RegressionConfig RegressionConfig::fromEnv() {
+    RegressionConfig config;
+    config.goldenPath = envString("REGRESS_GOLDEN", config.goldenPath);
+    config.baselinePath = envString("REGRESS_BASELINE", config.baselinePath);
+    config.countTolerance = static_cast<int>(envInt("REGRESS_COUNT_TOLERANCE", config.countTolerance));
+    config.boxTolerance = static_cast<int>(envInt("REGRESS_BOX_TOLERANCE", config.boxTolerance));
+    config.densityTolerance = envDouble("REGRESS_DENSITY_TOLERANCE", config.densityTolerance);
+    config.iouThreshold = envDouble("REGRESS_IOU_THRESHOLD", config.iouThreshold);
+    config.latencyMargin = envDouble("REGRESS_LATENCY_MARGIN", config.latencyMargin);
+    return config;
+}
+
+// Per-image stage latencies (ms); medians of these form the baseline.
+static const vector<string> kStages = {"preprocess_ms", "blob_ms", "inference_ms", "decode_ms", "total_ms"};
+
+static double iou(const Rect& a, const Rect& b) {
+    double inter = (a & b).area();
+    double uni = a.area() + b.area() - inter;
+    return uni > 0.0 ? inter / uni : 0.0;
+}
+
+static double median(vector<double> values) {
+    if (values.empty()) return 0.0;
+    size_t mid = values.size() / 2;
+    nth_element(values.begin(), values.begin() + mid, values.end());
+    return values[mid];
+}
+
+static json loadJson(const string& path) {
+    ifstream file(path);
+    if (!file.is_open()) return nullptr;
+    try {
+        return json::parse(file);
+    } catch (const json::exception& e) {
+        cerr << "[REGRESS] Invalid JSON in " << path << ": " << e.what() << "\n";
+        return nullptr;
+    }
+}
+
+static bool saveJson(const string& path, const json& data) {
+    error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+    ofstream file(path);
+    if (!file.is_open()) {
+        cerr << "[REGRESS] Cannot write " << path << "\n";
+        return false;
+    }
+    file << data.dump(2) << "\n";
+    return true;
+}
+
+// Number of `reference` boxes without an `other` box overlapping at
+// iouThreshold. Matching is greedy on the best IoU, each `other` box used at
+// most once. Called both ways round: golden vs. current gives missing boxes,
+// current vs. golden gives extra (spurious) ones.
+static int unmatchedBoxes(const vector<Rect>& reference, const vector<Rect>& other, double iouThreshold) {
+    vector<bool> used(other.size(), false);
+    int unmatched = 0;
+    for (const Rect& r : reference) {
+        int best = -1;
+        double bestIou = iouThreshold;
+        for (size_t i = 0; i < other.size(); ++i) {
+            if (used[i]) continue;
+            double overlap = iou(r, other[i]);
+            if (overlap >= bestIou) {
+                bestIou = overlap;
+                best = static_cast<int>(i);
+            }
+        }
+        if (best >= 0) used[best] = true;
+        else unmatched++;
+    }
+    return unmatched;
+}
+
+// Bundled images in a stable order; keys are relative to imagesRoot.
+static vector<string> collectImages(const RegressionConfig& config) {
+    vector<string> images;
+    for (const string& dir : config.imageDirs) {
+        fs::path path = fs::path(config.imagesRoot) / dir;
+        error_code ec;
+        for (const auto& entry : fs::directory_iterator(path, ec)) {
+            string ext = entry.path().extension().string();
+            transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            if (ext == ".jpg" || ext == ".jpeg" || ext == ".png") {
+                images.push_back(fs::relative(entry.path(), config.imagesRoot).generic_string());
+            }
+        }
+    }
+    sort(images.begin(), images.end());
+    return images;
+}
+
+int runRegressionSuite(const RegressionConfig& config) {
+    vector<string> images = collectImages(config);
+    if (images.empty()) {
+        cerr << "[REGRESS] No images found under " << config.imagesRoot << "\n";
+        return 1;
+    }
+
+    json golden = config.update ? json(nullptr) : loadJson(config.goldenPath);
+    json baseline = config.update ? json(nullptr) : loadJson(config.baselinePath);
+    if (!config.update && golden.is_null()) {
+        if (fs::exists(config.goldenPath)) {
+            cerr << "[REGRESS] Cannot use golden file " << config.goldenPath << "\n";
+            return 1;
+        }
+        cerr << "[REGRESS] SKIP Golden file missing: " << config.goldenPath
+             << " (run './main_exec regress --update' on a trusted build)\n";
+        return kRegressionSkipped;
+    }
+    if (!config.update && !(golden.is_object() && golden.contains("images") && golden["images"].is_object())) {
+        cerr << "[REGRESS] " << config.goldenPath << " has no \"images\" object\n";
+        return 1;
+    }
+
+    // Warm-up: the first call loads the YOLO model and allocates buffers.
+    {
+        Mat warm = imread((fs::path(config.imagesRoot) / images.front()).string());
+        if (!warm.empty()) analyzeTrafficFrame(preprocess_frame(warm));
+    }
+
+    json results = json::object();
+    map<string, vector<double>> latencies;
+    int failures = 0;
+
+    for (const string& key : images) {
+        Mat frame = imread((fs::path(config.imagesRoot) / key).string());
+        if (frame.empty()) {
+            cerr << "[REGRESS] FAIL " << key << ": cannot read image\n";
+            failures++;
+            continue;
+        }
+
+        using clock = chrono::steady_clock;
+        auto start = clock::now();
+        Mat processed = preprocess_frame(frame);
+        double preprocessMs = chrono::duration<double, milli>(clock::now() - start).count();
+        TrafficAnalysis analysis = analyzeTrafficFrame(processed);
+        double totalMs = chrono::duration<double, milli>(clock::now() - start).count();
+
+        if (!analysis.ok) {
+            cerr << "[REGRESS] FAIL " << key << ": " << analysis.report << "\n";
+            failures++;
+            continue;
+        }
+
+        latencies["preprocess_ms"].push_back(preprocessMs);
+        latencies["blob_ms"].push_back(analysis.timings.blobMs);
+        latencies["inference_ms"].push_back(analysis.timings.inferenceMs);
+        latencies["decode_ms"].push_back(analysis.timings.decodeMs);
+        latencies["total_ms"].push_back(totalMs);
+
+        json boxes = json::array();
+        for (const Rect& b : analysis.boxes) boxes.push_back({b.x, b.y, b.width, b.height});
+        results[key] = {{"vehicle_count", analysis.vehicleCount},
+                        {"density", analysis.density},
+                        {"boxes", boxes}};
+
+        if (config.update) continue;
+
+        if (!golden["images"].contains(key)) {
+            cout << "[REGRESS] NEW  " << key << " (no golden entry, not compared)\n";
+            continue;
+        }
+
+        int expectedCount = 0;
+        double expectedDensity = 0.0;
+        vector<Rect> expectedBoxes;
+        try {
+            const json& expected = golden["images"].at(key);
+            expectedCount = expected.at("vehicle_count").get<int>();
+            expectedDensity = expected.at("density").get<double>();
+            for (const auto& b : expected.at("boxes")) {
+                expectedBoxes.emplace_back(b.at(0).get<int>(), b.at(1).get<int>(), b.at(2).get<int>(), b.at(3).get<int>());
+            }
+        } catch (const json::exception& e) {
+            cerr << "[REGRESS] FAIL " << key << ": malformed golden entry (" << e.what() << ")\n";
+            failures++;
+            continue;
+        }
+
+        int countDiff = abs(analysis.vehicleCount - expectedCount);
+        double densityDiff = fabs(analysis.density - expectedDensity);
+        int missing = unmatchedBoxes(expectedBoxes, analysis.boxes, config.iouThreshold);
+        int extra = unmatchedBoxes(analysis.boxes, expectedBoxes, config.iouThreshold);
+
+        bool ok = countDiff <= config.countTolerance &&
+                  densityDiff <= config.densityTolerance &&
+                  missing <= config.boxTolerance &&
+                  extra <= config.boxTolerance;
+        if (!ok) failures++;
+
+        cout << "[REGRESS] " << (ok ? "PASS " : "FAIL ") << key
+             << " count=" << analysis.vehicleCount << " (golden " << expectedCount << ")"
+             << " density_diff=" << fixed << setprecision(4) << densityDiff
+             << " missing_boxes=" << missing << " extra_boxes=" << extra << "\n";
+    }
+
+    if (!config.update) {
+        for (const auto& item : golden["images"].items()) {
+            if (!results.contains(item.key())) {
+                cerr << "[REGRESS] FAIL " << item.key() << ": golden image missing or not analyzed\n";
+                failures++;
+            }
+        }
+    }
+
+    json medians = json::object();
+    for (const string& stage : kStages) medians[stage] = median(latencies[stage]);
+
+    if (config.update) {
+        json goldenOut = {{"images", results}};
+        json baselineOut = {{"stages", medians}, {"images", results.size()}};
+        bool saved = saveJson(config.goldenPath, goldenOut) && saveJson(config.baselinePath, baselineOut);
+        cout << "[REGRESS] Wrote " << results.size() << " golden entries to " << config.goldenPath
+             << " and latency baseline to " << config.baselinePath << "\n";
+        return (saved && failures == 0) ? 0 : 1;
+    }
+
+    // Latency gate: compare medians so a single slow frame doesn't flip the result.
+    if (config.latencyMargin < 0.0) {
+        cout << "[REGRESS] Latency check skipped (REGRESS_LATENCY_MARGIN < 0)\n";
+    } else if (!baseline.is_object() || !baseline.contains("stages") || !baseline["stages"].is_object()) {
+        // Never pass silently without the gate; REGRESS_LATENCY_MARGIN=-1 opts out.
+        cerr << "[REGRESS] FAIL latency baseline missing or invalid: " << config.baselinePath
+             << " (set REGRESS_LATENCY_MARGIN=-1 to skip the latency check)\n";
+        failures++;
+    } else {
+        for (const string& stage : kStages) {
+            if (!baseline["stages"].contains(stage)) continue;
+            if (!baseline["stages"][stage].is_number()) {
+                cerr << "[REGRESS] FAIL " << stage << ": baseline value is not a number\n";
+                failures++;
+                continue;
+            }
+            double reference = baseline["stages"][stage].get<double>();
+            double current = medians[stage].get<double>();
+            double limit = reference * (1.0 + config.latencyMargin);
+            bool ok = reference <= 0.0 || current <= limit;
+            if (!ok) failures++;
+            cout << "[REGRESS] " << (ok ? "PASS " : "FAIL ") << stage
+                 << " median=" << fixed << setprecision(2) << current << "ms"
+                 << " baseline=" << reference << "ms limit=" << limit << "ms\n";
+        }
+    }
+
+    cout << "[REGRESS] " << images.size() << " images, " << failures << " failure(s)\n";
+    return failures == 0 ? 0 : 1;
+}
+
+int runBlobBenchmark(const RegressionConfig& config, int iterations) {
+    vector<string> images = collectImages(config);
+    if (images.empty()) {
+        cerr << "[BENCH] No images found under " << config.imagesRoot << "\n";
+        return 1;
+    }
+    iterations = max(1, iterations);
+
+    using Clock = chrono::steady_clock;
+    auto elapsedMs = [](Clock::time_point start) {
+        return chrono::duration<double, milli>(Clock::now() - start).count();
+    };
+
+    // Both paths reuse their output tensor, as analyzeTrafficFrame does.
+    Mat stretched, letterboxed;
+    vector<double> stretchMs, letterboxMs;
+    for (const string& key : images) {
+        Mat frame = imread((fs::path(config.imagesRoot) / key).string());
+        if (frame.empty()) {
+            cerr << "[BENCH] Cannot read " << key << "\n";
+            continue;
+        }
+        dnn::blobFromImage(frame, stretched, 0.00392, Size(416, 416), Scalar(0, 0, 0), true, false);
+        letterboxBlob(frame, 416, letterboxed);
+
+        for (int i = 0; i < iterations; ++i) {
+            auto start = Clock::now();
+            dnn::blobFromImage(frame, stretched, 0.00392, Size(416, 416), Scalar(0, 0, 0), true, false);
+            stretchMs.push_back(elapsedMs(start));
+
+            start = Clock::now();
+            letterboxBlob(frame, 416, letterboxed);
+            letterboxMs.push_back(elapsedMs(start));
+        }
+    }
+    if (stretchMs.empty()) return 1;
+
+    double before = median(stretchMs);
+    double after = median(letterboxMs);
+    cout << fixed << setprecision(3)
+         << "[BENCH] " << images.size() << " images x " << iterations << " runs, median per frame\n"
+         << "[BENCH] blobFromImage   " << before << " ms\n"
+         << "[BENCH] letterboxBlob   " << after << " ms\n"
+         << setprecision(2) << "[BENCH] speedup         " << (after > 0.0 ? before / after : 0.0) << "x\n";
+    return 0;
+}
@@ -0,0 +1,147 @@
+// Local camera simulator: serves N synthetic MJPEG cameras over localhost HTTP
+// from a directory of stored frames, so the pipeline can be load tested offline.
+//
+//   ./camera_sim            (configured through SIM_* environment variables)
+//
+// Camera i is available at http://127.0.0.1:<SIM_PORT>/stream/cam<i> and
+// /snapshot/cam<i>. Point main_exec at them with './main_exec load'.
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "env_config.hpp"
+#include "mjpeg_server.hpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static atomic<bool> g_running{true};
+
+struct SimulatorConfig {
+    string framesDir = "../resources/images/avenida_dos_estados";
+    int cameras = 4;
+    int port = 8090;
+    string bindAddress = "127.0.0.1";  // the simulator is for local load tests only
+    double fps = 5.0;
+    int width = 0;              // 0 keeps the stored resolution
+    int height = 0;
+    int jitterMs = 0;           // uniform +/- jitter on every frame interval
+    double dropoutRate = 0.0;   // probability per frame that a camera drops out
+    int dropoutMs = 3000;       // how long a dropout lasts
+    bool dropoutDisconnects = false;  // also close the client connections
+    int jpegQuality = 80;
+
+    static SimulatorConfig fromEnv() {
+        SimulatorConfig c;
+        c.framesDir = envString("SIM_FRAMES_DIR", c.framesDir);
+        c.cameras = max(1, static_cast<int>(envInt("SIM_CAMERAS", c.cameras)));
+        c.port = static_cast<int>(envInt("SIM_PORT", c.port));
+        c.bindAddress = envString("SIM_BIND", c.bindAddress);
+        c.fps = max(0.1, envDouble("SIM_FPS", c.fps));
+        c.width = max(0, static_cast<int>(envInt("SIM_WIDTH", c.width)));
+        c.height = max(0, static_cast<int>(envInt("SIM_HEIGHT", c.height)));
+        c.jitterMs = max(0, static_cast<int>(envInt("SIM_JITTER_MS", c.jitterMs)));
+        c.dropoutRate = clamp(envDouble("SIM_DROPOUT_RATE", c.dropoutRate), 0.0, 1.0);
+        c.dropoutMs = max(0, static_cast<int>(envInt("SIM_DROPOUT_MS", c.dropoutMs)));
+        c.dropoutDisconnects = envInt("SIM_DROPOUT_DISCONNECT", 0) != 0;
+        c.jpegQuality = static_cast<int>(clamp(envInt("SIM_JPEG_QUALITY", c.jpegQuality), 1L, 100L));
+        return c;
+    }
+};
+
+// Frames are decoded, resized and encoded once; every camera shares them.
+static vector<JpegBuffer> loadFrames(const SimulatorConfig& config) {
+    vector<fs::path> paths;
+    error_code ec;
+    for (const auto& entry : fs::directory_iterator(config.framesDir, ec)) {
+        string ext = entry.path().extension().string();
+        transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (ext == ".jpg" || ext == ".jpeg" || ext == ".png") paths.push_back(entry.path());
+    }
+    sort(paths.begin(), paths.end());
+
+    vector<JpegBuffer> frames;
+    vector<int> params = {cv::IMWRITE_JPEG_QUALITY, config.jpegQuality};
+    for (const auto& path : paths) {
+        cv::Mat image = cv::imread(path.string());
+        if (image.empty()) continue;
+        if (config.width > 0 && config.height > 0) {
+            cv::resize(image, image, cv::Size(config.width, config.height));
+        }
+        auto jpeg = make_shared<vector<unsigned char>>();
+        cv::imencode(".jpg", image, *jpeg, params);
+        frames.push_back(jpeg);
+    }
+    return frames;
+}
+
+static void runCamera(int index, const SimulatorConfig& config, const vector<JpegBuffer>& frames, MjpegServer& server) {
+    const string name = "cam" + to_string(index);
+    mt19937 rng(1234 + index);  // deterministic per camera so runs are comparable
+    uniform_int_distribution<int> jitter(-config.jitterMs, config.jitterMs);
+    bernoulli_distribution dropout(config.dropoutRate);
+
+    const auto period = chrono::duration<double, milli>(1000.0 / config.fps);
+    size_t frame = index % frames.size();  // cameras start at different frames
+    auto next = chrono::steady_clock::now();
+
+    while (g_running) {
+        if (dropout(rng)) {
+            // No frame at all while the camera is down, so /snapshot polls
+            // see the dropout (503) just like stream clients do.
+            server.clearFrame(name);
+            if (config.dropoutDisconnects) server.disconnectClients(name);
+            this_thread::sleep_for(chrono::milliseconds(config.dropoutMs));
+            next = chrono::steady_clock::now();
+            continue;
+        }
+
+        server.publishJpeg(name, frames[frame]);
+        frame = (frame + 1) % frames.size();
+
+        next += chrono::duration_cast<chrono::steady_clock::duration>(period) + chrono::milliseconds(jitter(rng));
+        this_thread::sleep_until(next);
+    }
+}
+
+int main() {
+    SimulatorConfig config = SimulatorConfig::fromEnv();
+
+    vector<JpegBuffer> frames = loadFrames(config);
+    if (frames.empty()) {
+        cerr << "[SIM] No frames found in " << config.framesDir << "\n";
+        return 1;
+    }
+
+    MjpegServer server(config.port, config.bindAddress);
+    if (!server.start()) return 1;
+
+    signal(SIGINT, [](int) { g_running = false; });
+    signal(SIGTERM, [](int) { g_running = false; });
+
+    cout << "[SIM] " << config.cameras << " cameras, " << frames.size() << " frames, "
+         << config.fps << " fps, jitter " << config.jitterMs << " ms, dropout rate "
+         << config.dropoutRate << "\n";
+    cout << "[SIM] http://" << config.bindAddress << ":" << server.port() << "/stream/cam0 .. cam" << config.cameras - 1
+         << " (Ctrl+C to stop)\n";
+
+    vector<thread> cameras;
+    for (int i = 0; i < config.cameras; ++i) {
+        cameras.emplace_back(runCamera, i, cref(config), cref(frames), ref(server));
+    }
+    for (auto& camera : cameras) camera.join();
+
+    server.stop();
+    cout << "[SIM] Stopped\n";
+    return 0;
+}
@@ -1,4 +1,6 @@
-void drawDebugGrid(cv::Mat& frame, int step = 100) {
+#include "debug_frame.hpp"
+
+void drawDebugGrid(cv::Mat& frame, int step) {
     cv::Scalar gridColor(100, 100, 100);  // light gray
     int thickness = 1;
     int font = cv::FONT_HERSHEY_SIMPLEX;